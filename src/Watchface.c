@@ -8,18 +8,23 @@
 
 #include <pebble.h>
 #include "effect_layer.h"
-
-#define KEY_MINUTE_COLOR_R 0
-#define KEY_MINUTE_COLOR_G 1
-#define KEY_MINUTE_COLOR_B 2
-#define KEY_HOUR_COLOR_R 3
-#define KEY_HOUR_COLOR_G 4
-#define KEY_HOUR_COLOR_B 5
-
-#define GRECT_FULL_WINDOW GRect(0,0,144,168)
-
-// Settings
+#include "settings.h"
+#include "theme.h"
+#include "battery.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "energy.h"
+#include "overdraw.h"
+#include "animator.h"
+#include "glyph.h"
+#include "raster.h"
+#include "time_state.h"
+#include "render_tier.h"
+
+// Settings, the host harness builds both date formats
+#ifndef USE_AMERICAN_DATE_FORMAT
 #define USE_AMERICAN_DATE_FORMAT      true
+#endif
 
 // Magic numbers
 #define SCREEN_WIDTH        144
@@ -44,25 +49,32 @@
 #define DATE_CONTAINER_HEIGHT SCREEN_HEIGHT - SCREEN_WIDTH
 #define DATE_DAY_GAP        2
 
-#define BATTERY_IMAGE_WIDTH 8
-#define BATTERY_IMAGE_HEIGHT 15
-
-#define MINUTE_COLOR GColorArmyGreen
-#define HOUR_COLOR GColorLiberty
 #define MINUTE_BUFFER 15
 #define MINUTE_SIZE MINUTE_BUFFER
 #define HOUR_BUFFER 40
 #define HOUR_SIZE 20
+#define HAND_WIDTH 3
 
+#define DIGIT_SLIDE_MS      300
+#define HAND_SWEEP_MS       400
+#define HOUR_PULSE_MS       600
+#define HOUR_PULSE_PERCENT  120
+
+// replays need exactly one deterministic frame per tick
+#ifdef PROFILE_SWEEP
+#define ANIMATE_UPDATES     false
+#else
+#define ANIMATE_UPDATES     true
+#endif
 
 
 // Images
 #define NUMBER_OF_TIME_IMAGES 10
-const int TIME_IMAGE_RESOURCE_IDS[NUMBER_OF_TIME_IMAGES] = {
-  RESOURCE_ID_IMAGE_TIME_0, 
-  RESOURCE_ID_IMAGE_TIME_1, RESOURCE_ID_IMAGE_TIME_2, RESOURCE_ID_IMAGE_TIME_3, 
-  RESOURCE_ID_IMAGE_TIME_4, RESOURCE_ID_IMAGE_TIME_5, RESOURCE_ID_IMAGE_TIME_6, 
-  RESOURCE_ID_IMAGE_TIME_7, RESOURCE_ID_IMAGE_TIME_8, RESOURCE_ID_IMAGE_TIME_9
+const int TIME_GLYPH_RESOURCE_IDS[NUMBER_OF_TIME_IMAGES] = {
+  RESOURCE_ID_GLYPH_TIME_0, 
+  RESOURCE_ID_GLYPH_TIME_1, RESOURCE_ID_GLYPH_TIME_2, RESOURCE_ID_GLYPH_TIME_3, 
+  RESOURCE_ID_GLYPH_TIME_4, RESOURCE_ID_GLYPH_TIME_5, RESOURCE_ID_GLYPH_TIME_6, 
+  RESOURCE_ID_GLYPH_TIME_7, RESOURCE_ID_GLYPH_TIME_8, RESOURCE_ID_GLYPH_TIME_9
 };
 
 #define NUMBER_OF_SMALL_DIGIT_IMAGES 10
@@ -85,17 +97,11 @@ const int DAY_IMAGE_RESOURCE_IDS[NUMBER_OF_DAY_IMAGES] = {
 Layer *root_layer;
 Window *window;
 
-static uint8_t battery_level;
-static bool battery_plugged;
-static GBitmap *icon_battery;
-static GBitmap *icon_battery_charge;
+static BatteryRenderer battery_renderer;
 static Layer *battery_layer;
 
 static AppTimer *recheck_bluetooth_timer;
 
-static EffectLayer *full_inverse_layer;
-static Layer *inverter_layer;
-
 #define EMPTY_SLOT -1
 
 typedef struct Slot {
@@ -105,9 +111,17 @@ typedef struct Slot {
   int           state;
 } Slot;
 
+// Time digits are run-length glyphs drawn by time_layer's update proc
+typedef struct TimeSlot {
+  int           number;
+  Glyph         *glyph;
+  int           state;
+  int16_t       shown_height;  // rows shown, less than the glyph while it slides in
+} TimeSlot;
+
 #define NUMBER_OF_TIME_SLOTS 4
 Layer *time_layer;
-Slot time_slots[NUMBER_OF_TIME_SLOTS];
+TimeSlot time_slots[NUMBER_OF_TIME_SLOTS];
 
 // Date
 typedef struct DateSlot {
@@ -125,40 +139,104 @@ typedef struct ImageItem {
   BitmapLayer   *image_layer;
   GBitmap       *bitmap;
   GRect         frame;
+  uint32_t      resource_id;
   bool          loaded;
 } ImageItem;
 ImageItem day_item;
 ImageItem slash_item;
 
+// Hands, swept from where they were last drawn to the committed time
+typedef struct HandSweep {
+  int       from_hour_angle;
+  int       from_minute_angle;
+  int       hour_angle;      // as last drawn
+  int       minute_angle;
+  uint32_t  progress;
+} HandSweep;
+HandSweep hand_sweep = { .progress = ANIMATOR_PROGRESS_MAX };
+
+// Time glyphs decoded a few seconds before the minute they are shown in
+#define PRERENDER_LEAD_S 3
+typedef struct PrerenderedDigit {
+  Glyph         *glyph;
+  int           digit;
+} PrerenderedDigit;
+PrerenderedDigit prerendered_digits[NUMBER_OF_TIME_SLOTS];
+static AppTimer *prerender_timer;
+
+// Zooms the hour row when the hour changes
+EffectLayer *hour_pulse_layer;
+Effect *hour_pulse;  // zoom on hour_pulse_layer while the hour pulses
+
+// What is drawn at the current battery charge
+static RenderTier render_tier = RENDER_TIER_FULL;
+
+// Time state of the last committed tick
+TimeState time_state;
+static const TimeStateLayout time_layout = {
+  .screen = { SCREEN_WIDTH, SCREEN_HEIGHT },
+  .hour_inset = HOUR_BUFFER,
+  .minute_inset = MINUTE_BUFFER,
+  .month_first = USE_AMERICAN_DATE_FORMAT
+};
+
 // General
 BitmapLayer *load_digit_image_into_slot(Slot *slot, int digit_value, Layer *parent_layer, GRect frame, const int *digit_resource_ids);
 void unload_digit_image_from_slot(Slot *slot);
 void unload_image_item(ImageItem * item);
 void unload_day();
 void unload_slash();
-void create_date_layer(struct tm *tick_time);
+void layout_date(const TimeState *state);
 
 // Display
-void display_time(struct tm *tick_time);
-void display_date(struct tm *tick_time);
-void display_day(struct tm *tick_time);
+void display_time(const TimeState *state);
+void display_date(const TimeState *state);
+void display_day(const TimeState *state);
 void display_slash();
 
 // Time
-void display_time_value(int value, int row_number);
-void update_time_slot(Slot *time_slot, int digit_value);
-GRect frame_for_time_slot(Slot *time_slot);
+void update_time_slot(TimeSlot *time_slot, int digit_value);
+void unload_time_slot(TimeSlot *time_slot);
+GRect frame_for_time_slot(TimeSlot *time_slot);
 
 // Date
-void display_date_value(int value, int part_number);
 void update_date_slot(DateSlot *date_slot, int digit_value);
 
+// Update transaction
+// State changes staged by event handlers and applied together at commit
+typedef struct UiTransaction {
+  bool      staged;
+  bool      animate;
+  struct tm time;
+  time_t    start_s;
+  uint16_t  start_ms;
+} UiTransaction;
+UiTransaction ui_transaction;
+uint16_t ui_worst_commit_ms;
+
+void ui_begin_update();
+void ui_stage_time(struct tm *tick_time);
+void ui_commit_update();
+
+// Pre-render
+static void schedule_prerender();
+static void cancel_prerender();
+static void prerender_next_minute(void *data);
+static Glyph *take_prerendered_digit(int slot_number, int digit);
+static void discard_prerendered_digits();
+
+// Transitions
+static void slide_digit(void *context, uint32_t progress);
+static void sweep_hands(void *context, uint32_t progress);
+static void pulse_hours(void *context, uint32_t progress);
+
 // Connection
 void fail_mode();
 void reset_fail_mode();
 
 // handlers
 static void handle_battery(BatteryChargeState charge_state);
+static void update_render_tier(BatteryChargeState charge);
 static void handle_tick(struct tm *tick_time, TimeUnits units_changed);
 
 // startup
@@ -166,49 +244,32 @@ void init();
 void deinit();
 
 // Config
-static GColor minute_color;
-static GColor hour_color;
+static Settings settings;
+static Theme theme;
 
 static void inbox_received_callback(DictionaryIterator *iter, void *context) {
-  int red, green, blue;
-  Tuple *color_red_t, *color_green_t, *color_blue_t;
-  // Minute color?
-  color_red_t = dict_find(iter, KEY_MINUTE_COLOR_R);
-  color_green_t = dict_find(iter, KEY_MINUTE_COLOR_G);
-  color_blue_t = dict_find(iter, KEY_MINUTE_COLOR_B);
-  if(color_red_t && color_green_t && color_blue_t) {
-    // Apply the color if available
-      red = color_red_t->value->int32;
-      green = color_green_t->value->int32;
-      blue = color_blue_t->value->int32;
-  
-      // Persist values
-      persist_write_int(KEY_MINUTE_COLOR_R, red);
-      persist_write_int(KEY_MINUTE_COLOR_G, green);
-      persist_write_int(KEY_MINUTE_COLOR_B, blue);
-  
-      minute_color = GColorFromRGB(red, green, blue);
-  }
-  // Hour color?
-  color_red_t = dict_find(iter, KEY_HOUR_COLOR_R);
-  color_green_t = dict_find(iter, KEY_HOUR_COLOR_G);
-  color_blue_t = dict_find(iter, KEY_HOUR_COLOR_B);
-  if(color_red_t && color_green_t && color_blue_t) {
-    // Apply the color if available
-      red = color_red_t->value->int32;
-      green = color_green_t->value->int32;
-      blue = color_blue_t->value->int32;
-  
-      // Persist values
-      persist_write_int(KEY_HOUR_COLOR_R, red);
-      persist_write_int(KEY_HOUR_COLOR_G, green);
-      persist_write_int(KEY_HOUR_COLOR_B, blue);
-  
-      hour_color = GColorFromRGB(red, green, blue);
+  energy_count(ENERGY_MESSAGE, 1);
+  Tuple *config_t = dict_find(iter, KEY_CONFIG);
+  if (!config_t || config_t->type != TUPLE_BYTE_ARRAY) {
+    return;
   }
 
-  layer_mark_dirty(root_layer);
+  Settings updated = settings;
+  if (!settings_apply_config(&updated, config_t->value->data, config_t->length)) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Malformed config!");
+    return;
+  }
+
+  if (memcmp(&updated, &settings, sizeof(Settings)) == 0) {
+    return;
+  }
+  settings = updated;
+  theme_init(&theme, &settings, theme.inverted);
+  update_render_tier(battery_state_service_peek());
 
+  // Persist values, only touches flash if they differ from what is stored
+  settings_save(&settings);
+  layer_mark_dirty(root_layer);
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
@@ -220,25 +281,34 @@ static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResul
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
+  energy_count(ENERGY_MESSAGE, 1);
   APP_LOG(APP_LOG_LEVEL_INFO, "Outbox send success!");
 }
 
 
 // General
-BitmapLayer *load_digit_image_into_slot(Slot *slot, int digit_value, Layer *parent_layer, GRect frame, const int *digit_resource_ids) {
-  if (digit_value < 0 || digit_value > 19) {
-    return NULL;
-  }
+// color glyph bitmaps take theme.glyph_palette, so recoloring or inverting them
+// is a single palette write in theme_init; 1 bit ones are inverted in place
+static GBitmap *create_glyph_bitmap(uint32_t resource_id) {
+  GBitmap *bitmap = gbitmap_create_with_resource(resource_id);
+#ifdef PBL_COLOR
+  if (bitmap) gbitmap_set_palette(bitmap, theme.glyph_palette, false);
+#else
+  if (theme.inverted) theme_invert_bitmap(bitmap);
+#endif
+  return bitmap;
+}
 
-  if (slot->state != EMPTY_SLOT) {
+BitmapLayer *load_digit_image_into_slot(Slot *slot, int digit_value, Layer *parent_layer, GRect frame, const int *digit_resource_ids) {
+  if (digit_value < 0 || digit_value > 19 || slot->state != EMPTY_SLOT) {
     return NULL;
   }
 
   slot->state = digit_value;
   slot->image_layer = bitmap_layer_create(frame);
-  slot->bitmap = gbitmap_create_with_resource(digit_resource_ids[digit_value]);
+  slot->bitmap = create_glyph_bitmap(digit_resource_ids[digit_value]);
   bitmap_layer_set_bitmap(slot->image_layer, slot->bitmap);
-  bitmap_layer_set_compositing_mode(slot->image_layer, GCompOpSet);
+  bitmap_layer_set_compositing_mode(slot->image_layer, theme.compositing);
   Layer * layer = bitmap_layer_get_layer(slot->image_layer);
   layer_set_clips(layer, true);
   layer_add_child(parent_layer, layer);
@@ -285,87 +355,88 @@ void create_date_frames(int left_digit_count, int right_digit_count) {
   date_slots[3].frame.origin.x = date_slots[2].frame.origin.x + (right_digit_count > 1 ? SMALL_DIGIT_IMAGE_WIDTH : 0);
 }
 
-void create_date_layer(struct tm *tick_time) {
-  for (int i = 0; i < NUMBER_OF_DATE_SLOTS; ++i) {
-    unload_digit_image_from_slot(&date_slots[i].slot);
-  }
-  unload_slash();
+// Lays out the date for the digit counts of state, called when they change.
+// Only moves existing layers, nothing is reloaded
+void layout_date(const TimeState *state) {
+  int left_digit_count = state->date_left_digit_count;
+  int right_digit_count = state->date_right_digit_count;
 
-  if (date_layer != NULL) {
-    layer_remove_from_parent(date_layer);
-    layer_destroy(date_layer);
-    date_layer = NULL;
-  }
-  int month_digit_count = tick_time->tm_mon > 8 ? 2 : 1;
-  int day_digit_count = tick_time->tm_mday > 9 ? 2 : 1; 
-
-  date_layer_width = SMALL_DIGIT_IMAGE_WIDTH * month_digit_count + DATE_PART_SPACE + SMALL_DIGIT_IMAGE_WIDTH * day_digit_count;
+  date_layer_width = SMALL_DIGIT_IMAGE_WIDTH * left_digit_count + DATE_PART_SPACE + SMALL_DIGIT_IMAGE_WIDTH * right_digit_count;
   GRect date_layer_rect = GRect(MARGIN, SCREEN_WIDTH + 4, date_layer_width, SMALL_DIGIT_IMAGE_HEIGHT + MARGIN);
-  date_layer = layer_create(date_layer_rect);  
-  layer_set_clips(date_layer, true);
-  layer_add_child(root_layer, date_layer);
+  if (date_layer == NULL) {
+    date_layer = layer_create(date_layer_rect);  
+    layer_set_clips(date_layer, true);
+    layer_add_child(root_layer, date_layer);
+  } else {
+    layer_set_frame(date_layer, date_layer_rect);
+  }
 
-#if USE_AMERICAN_DATE_FORMAT
-  slash_item.frame = GRect(month_digit_count * SMALL_DIGIT_IMAGE_WIDTH, 
-    0, DATE_PART_SPACE, SMALL_DIGIT_IMAGE_HEIGHT);
-  create_date_frames(month_digit_count, day_digit_count);
-#else
-  slash_item.frame = GRect(day_digit_count * SMALL_DIGIT_IMAGE_WIDTH, 
+  slash_item.frame = GRect(left_digit_count * SMALL_DIGIT_IMAGE_WIDTH, 
     0, DATE_PART_SPACE, SMALL_DIGIT_IMAGE_HEIGHT);
-  create_date_frames(day_digit_count, month_digit_count);
-#endif
+  create_date_frames(left_digit_count, right_digit_count);
+
+  // move whatever is already loaded, display_date/display_slash swap the rest
+  for (int i = 0; i < NUMBER_OF_DATE_SLOTS; ++i) {
+    if (date_slots[i].slot.state != EMPTY_SLOT) {
+      layer_set_frame(bitmap_layer_get_layer(date_slots[i].slot.image_layer), date_slots[i].frame);
+    }
+  }
 }
 
 
 // Display
-void display_time(struct tm *tick_time) {
-  int hour = tick_time->tm_hour;
-
-  if (!clock_is_24h_style()) {
-    hour = hour % 12;
-    if (hour == 0) {
-      hour = 12;
+void display_time(const TimeState *state) {
+  for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
+    if (state->digits[i] == TIME_STATE_EMPTY) {
+      unload_time_slot(&time_slots[i]);
+    } else {
+      update_time_slot(&time_slots[i], state->digits[i]);
     }
   }
-
-  display_time_value(hour,              0);
-  display_time_value(tick_time->tm_min, 1);
 }
 
-void display_date(struct tm *tick_time) {
-  int day   = tick_time->tm_mday;
-  int month = tick_time->tm_mon + 1;
-
-#if USE_AMERICAN_DATE_FORMAT
-  display_date_value(month, 0);
-  display_date_value(day,   1);
-#else
-  display_date_value(day,   0);
-  display_date_value(month, 1);
-#endif
+void display_date(const TimeState *state) {
+  for (int i = 0; i < NUMBER_OF_DATE_SLOTS; i++) {
+    if (state->date_digits[i] == TIME_STATE_EMPTY) {
+      unload_digit_image_from_slot(&date_slots[i].slot);
+    } else {
+      update_date_slot(&date_slots[i], state->date_digits[i]);
+    }
+  }
 }
 
 
+// Shows resource_id at item->frame, reusing the item's layer and bitmap when possible
 void display_item(ImageItem * item, uint32_t resource_id, Layer *parent) {
   if (item->loaded) {
-    layer_remove_from_parent(bitmap_layer_get_layer(item->image_layer));
-    gbitmap_destroy(item->bitmap);
-    bitmap_layer_destroy(item->image_layer);
+    if (item->resource_id != resource_id) {
+      gbitmap_destroy(item->bitmap);
+      item->bitmap = create_glyph_bitmap(resource_id);
+      bitmap_layer_set_bitmap(item->image_layer, item->bitmap);
+      item->resource_id = resource_id;
+    }
+    Layer * layer = bitmap_layer_get_layer(item->image_layer);
+    GRect frame = layer_get_frame(layer);
+    if (!grect_equal(&frame, &item->frame)) {
+      layer_set_frame(layer, item->frame);
+    }
+    return;
   }
 
   item->image_layer = bitmap_layer_create(item->frame);
-  item->bitmap = gbitmap_create_with_resource(resource_id);
+  item->bitmap = create_glyph_bitmap(resource_id);
   bitmap_layer_set_bitmap(item->image_layer, item->bitmap);
-  bitmap_layer_set_compositing_mode(item->image_layer, GCompOpSet);
+  bitmap_layer_set_compositing_mode(item->image_layer, theme.compositing);
   Layer * layer = bitmap_layer_get_layer(item->image_layer);
   layer_set_clips(layer, true);
   layer_add_child(parent, layer);
 
+  item->resource_id = resource_id;
   item->loaded = true;
 }
 
-void display_day(struct tm *tick_time) {
-  int ix = tick_time->tm_wday;
+void display_day(const TimeState *state) {
+  int ix = state->weekday;
   day_item.frame = GRect(
     date_layer_width + MARGIN + DATE_DAY_GAP, 
     SCREEN_WIDTH + 4, 
@@ -380,40 +451,42 @@ void display_slash() {
 }
 
 // Time
-void display_time_value(int value, int row_number) {
-  value = value % 100; // Maximum of two digits per row.
-
-  for (int column_number = 1; column_number >= 0; column_number--) {
-
-    int time_slot_number = (row_number * 2) + column_number;
-
-    Slot *time_slot = &time_slots[time_slot_number];
+void update_time_slot(TimeSlot *time_slot, int digit_value) {
+  if (time_slot->state == digit_value || digit_value < 0 || digit_value >= NUMBER_OF_TIME_IMAGES) {
+    return;
+  }
 
-    if (row_number == 0 && value == 0 && column_number == 0) { // ignore the leading 0 for hours
-      unload_digit_image_from_slot(time_slot);
-      return;
-    }
-	
-    int ix = value % 10;       
-    update_time_slot(time_slot, ix);
+  // loaded ahead of the tick if it was prerendered
+  Glyph *glyph = take_prerendered_digit(time_slot->number, digit_value);
+  if (!glyph) {
+    glyph = glyph_create_with_resource(TIME_GLYPH_RESOURCE_IDS[digit_value]);
+  }
+  if (!glyph) {
+    return;
+  }
 
-    value = value / 10;
+  unload_time_slot(time_slot);
+  time_slot->glyph = glyph;
+  time_slot->state = digit_value;
+  time_slot->shown_height = TIME_IMAGE_HEIGHT;
+  layer_mark_dirty(time_layer);
+  if (ui_transaction.animate) {
+    animator_start(slide_digit, time_slot, DIGIT_SLIDE_MS);
   }
 }
 
-void update_time_slot(Slot *time_slot, int digit_value) {
-  if (time_slot->state == digit_value) {
+void unload_time_slot(TimeSlot *time_slot) {
+  if (time_slot->state == EMPTY_SLOT) {
     return;
   }
 
-  GRect frame = frame_for_time_slot(time_slot);
-
-  unload_digit_image_from_slot(time_slot);
-  load_digit_image_into_slot(time_slot, digit_value, time_layer, frame, TIME_IMAGE_RESOURCE_IDS);
-
+  glyph_destroy(time_slot->glyph);
+  time_slot->glyph = NULL;
+  time_slot->state = EMPTY_SLOT;
+  layer_mark_dirty(time_layer);
 }
 
-GRect frame_for_time_slot(Slot *time_slot) {
+GRect frame_for_time_slot(TimeSlot *time_slot) {
   int x = MARGIN_TIME_X + (time_slot->number % 2) * (TIME_IMAGE_WIDTH + TIME_SLOT_SPACE);
   int y = MARGIN + (time_slot->number / 2) * (TIME_IMAGE_HEIGHT + TIME_SLOT_SPACE);
 
@@ -422,24 +495,6 @@ GRect frame_for_time_slot(Slot *time_slot) {
 
 
 // Date
-void display_date_value(int value, int part_number) {
-  value = value % 100; // Maximum of two digits per row.
-
-  for (int column_number = 1; column_number >= 0; column_number--) {
-
-    DateSlot *date_slot = &date_slots[column_number + part_number*2];
-
-    if (column_number == 0 && value == 0) {  // ignore the leading 0
-      unload_digit_image_from_slot(&date_slot->slot);
-    } else {
-      int ix = value % 10;
-      update_date_slot(date_slot, ix);
-    }
-
-    value = value / 10;
-  }
-}
-
 void update_date_slot(DateSlot *date_slot, int digit_value) {
   if (date_slot->slot.state == digit_value) {
     return;
@@ -451,13 +506,42 @@ void update_date_slot(DateSlot *date_slot, int digit_value) {
 }
 
 
+// inverts a loaded glyph and redraws it the way the current theme composites glyphs;
+// color glyphs already follow theme.glyph_palette
+static void invert_image(BitmapLayer *image_layer, GBitmap *bitmap) {
+#ifndef PBL_COLOR
+  theme_invert_bitmap(bitmap);
+#endif
+  bitmap_layer_set_compositing_mode(image_layer, theme.compositing);
+}
+
+// Swaps the theme and every loaded bitmap between normal and inverted colors,
+// so the disconnected state is drawn directly instead of post-processed.
+void set_inverted(bool inverted) {
+  if (theme.inverted == inverted) {
+    return;
+  }
+  theme_init(&theme, &settings, inverted);
+
+  for (int i = 0; i < NUMBER_OF_DATE_SLOTS; i++) {
+    if (date_slots[i].slot.state != EMPTY_SLOT) invert_image(date_slots[i].slot.image_layer, date_slots[i].slot.bitmap);
+  }
+  if (day_item.loaded) invert_image(day_item.image_layer, day_item.bitmap);
+  if (slash_item.loaded) invert_image(slash_item.image_layer, slash_item.bitmap);
+  battery_renderer_invert(&battery_renderer);
+
+  window_set_background_color(window, theme.background);
+  layer_mark_dirty(root_layer);
+}
+
 void fail_mode() {
   vibes_long_pulse();
-  layer_add_child(root_layer, inverter_layer);
+  energy_count(ENERGY_VIBE_MS, ENERGY_LONG_PULSE_MS);
+  set_inverted(true);
 }
 
 void reset_fail_mode() {
-  layer_remove_from_parent(inverter_layer);
+  set_inverted(false);
 }
 
 
@@ -468,50 +552,221 @@ int main() {
 }
 
 static void handle_battery(BatteryChargeState charge) {
+  energy_battery(charge);
+  if (battery_renderer_update(&battery_renderer, charge)) {
+    layer_mark_dirty(battery_layer);
+  }
+  update_render_tier(charge);
+}
+
+// switches what is drawn when the charge crosses the configured thresholds
+static void update_render_tier(BatteryChargeState charge) {
+  RenderTier tier = render_tier_for_charge(render_tier, charge, settings.power_saver_percent);
+  if (tier == render_tier) {
+    return;
+  }
+  APP_LOG(APP_LOG_LEVEL_INFO, "Render tier %s at %d%%", render_tier_name(tier), charge.charge_percent);
+  render_tier = tier;
 
-  battery_level = charge.charge_percent;
-  battery_plugged = charge.is_plugged;
-  layer_mark_dirty(battery_layer);
+  const RenderTierPolicy *policy = render_tier_policy(tier);
+  if (!policy->animate) {
+    // a running pulse removes its effect as it finishes
+    animator_finish_all();
+  }
+  layer_set_hidden(effect_layer_get_layer(hour_pulse_layer), !policy->effects);
+  if (policy->prerender) {
+    schedule_prerender();
+  } else {
+    cancel_prerender();
+  }
+  layer_mark_dirty(root_layer);
+}
+
+// Pre-render
+static void discard_prerendered_digits() {
+  for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
+    if (prerendered_digits[i].glyph) {
+      glyph_destroy(prerendered_digits[i].glyph);
+      prerendered_digits[i].glyph = NULL;
+    }
+  }
+}
+
+// hands over the decoded glyph if it is the one wanted, the caller owns it then
+static Glyph *take_prerendered_digit(int slot_number, int digit) {
+  PrerenderedDigit *prerendered = &prerendered_digits[slot_number];
+  if (!prerendered->glyph || prerendered->digit != digit) {
+    return NULL;
+  }
+  Glyph *glyph = prerendered->glyph;
+  prerendered->glyph = NULL;
+  return glyph;
+}
+
+// loads the glyphs the next minute will change to, so the tick only swaps pointers
+static void prerender_next_minute(void *data) {
+  prerender_timer = NULL;
+  energy_count(ENERGY_TIMER_WAKEUP, 1);
+  discard_prerendered_digits();
+
+  // from the last tick rather than the wall clock, which the sweep doesn't follow
+  struct tm next_minute = time_state.time;
+  next_minute.tm_sec = 0;
+  ++next_minute.tm_min;
+  mktime(&next_minute);
+  TimeState next = time_state;
+  time_state_update(&next, &next_minute, &time_layout);
+
+  for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
+    int digit = next.digits[i];
+    if (digit == TIME_STATE_EMPTY || digit == time_slots[i].state) {
+      continue;
+    }
+    prerendered_digits[i].digit = digit;
+    prerendered_digits[i].glyph = glyph_create_with_resource(TIME_GLYPH_RESOURCE_IDS[digit]);
+  }
+}
+
+static void schedule_prerender() {
+  if (!render_tier_policy(render_tier)->prerender) {
+    return;
+  }
+  if (prerender_timer) {
+    app_timer_cancel(prerender_timer);
+  }
+  int seconds_left = 60 - time_state.time.tm_sec;
+  prerender_timer = app_timer_register(MAX(seconds_left - PRERENDER_LEAD_S, 0) * 1000, prerender_next_minute, NULL);
+}
+
+static void cancel_prerender() {
+  if (prerender_timer) {
+    app_timer_cancel(prerender_timer);
+    prerender_timer = NULL;
+  }
+  discard_prerendered_digits();
+}
+
+// Transitions
+static void slide_digit(void *context, uint32_t progress) {
+  TimeSlot *time_slot = context;
+  if (time_slot->state == EMPTY_SLOT) {
+    return;
+  }
+  time_slot->shown_height = TIME_IMAGE_HEIGHT * animator_ease_out(progress) / ANIMATOR_PROGRESS_MAX;
+  layer_mark_dirty(time_layer);
+}
+
+static void sweep_hands(void *context, uint32_t progress) {
+  hand_sweep.progress = animator_ease_out(progress);
+  layer_mark_dirty(root_layer);
+}
+
+static void pulse_hours(void *context, uint32_t progress) {
+  if (progress < ANIMATOR_PROGRESS_MAX) {
+    // 100% up to HOUR_PULSE_PERCENT and back
+    uint32_t triangle = 2 * (progress < ANIMATOR_PROGRESS_MAX / 2 ? progress : ANIMATOR_PROGRESS_MAX - progress);
+    int zoom = 100 + (HOUR_PULSE_PERCENT - 100) * triangle / ANIMATOR_PROGRESS_MAX;
+    EffectParams params;
+    memset(&params, 0, sizeof(params));  // params are compared bytewise
+    params.zoom.x = params.zoom.y = EFFECT_ZOOM_PERCENT(zoom);
+    // the effect stays on the layer for the whole pulse, only its zoom changes
+    if (hour_pulse) {
+      effect_set_params(hour_pulse, &params);
+    } else if ((hour_pulse = effect_layer_add(hour_pulse_layer, &effect_type_zoom, &params))) {
+      effect_layer_set_decorative(hour_pulse_layer);
+    }
+  } else if (hour_pulse) {
+    effect_layer_remove_effect(hour_pulse_layer);
+    hour_pulse = NULL;
+  }
+  layer_mark_dirty(effect_layer_get_layer(hour_pulse_layer));
+}
+
+// angle from..to of the shortest way round, at progress
+static int sweep_angle(int from, int to, uint32_t progress) {
+  int delta = (to - from + 540) % 360 - 180;
+  return (from + delta * (int)progress / ANIMATOR_PROGRESS_MAX + 360) % 360;
 }
 
 static void handle_tick(struct tm *tick_time, TimeUnits units_changed) {
-  if ((units_changed & MINUTE_UNIT) == MINUTE_UNIT) {
-    display_time(tick_time);
+  telemetry_tick(tick_time);
+  energy_tick(tick_time);
+  ui_begin_update();
+  // what actually changed is worked out by the time state at commit
+  ui_stage_time(tick_time);
+  ui_commit_update();
+}
+
+// Update transaction
+void ui_begin_update() {
+  // a new tick never waits for the last one's transitions
+  animator_finish_all();
+  ui_transaction.staged = false;
+  ui_transaction.animate = ANIMATE_UPDATES && render_tier_policy(render_tier)->animate;
+  time_ms(&ui_transaction.start_s, &ui_transaction.start_ms);
+}
+
+void ui_stage_time(struct tm *tick_time) {
+  ui_transaction.time = *tick_time;
+  ui_transaction.staged = true;
+}
+
+// Recomputes the time state once and applies only what changed, with the
+// fewest layer mutations and a single invalidation; keeps track of the slowest commit
+void ui_commit_update() {
+  if (!ui_transaction.staged) {
+    return;
+  }
+  time_state_update(&time_state, &ui_transaction.time, &time_layout);
+  uint8_t changes = time_state.changes;
+  if (!changes) {
+    return;
   }
 
-  if ((units_changed & DAY_UNIT) == DAY_UNIT) {
-    create_date_layer(tick_time);
-    display_day(tick_time);
-    display_date(tick_time);
+  if (changes & TIME_STATE_DIGITS) {
+    display_time(&time_state);
+  }
+  if ((changes & TIME_STATE_HANDS) && ui_transaction.animate) {
+    hand_sweep.from_hour_angle = hand_sweep.hour_angle;
+    hand_sweep.from_minute_angle = hand_sweep.minute_angle;
+    if (!animator_start(sweep_hands, NULL, HAND_SWEEP_MS)) hand_sweep.progress = ANIMATOR_PROGRESS_MAX;
+  }
+  if ((changes & TIME_STATE_HOUR) && ui_transaction.animate) {
+    animator_start(pulse_hours, NULL, HOUR_PULSE_MS);
+  }
+  if (changes & TIME_STATE_DATE_LAYOUT) {
+    layout_date(&time_state);
     display_slash();
   }
+  if (changes & (TIME_STATE_WEEKDAY | TIME_STATE_DATE_LAYOUT)) {
+    display_day(&time_state);
+  }
+  if (changes & (TIME_STATE_DATE | TIME_STATE_DATE_LAYOUT)) {
+    display_date(&time_state);
+  }
+  schedule_prerender();
+  layer_mark_dirty(root_layer);
 
+  time_t end_s;
+  uint16_t end_ms;
+  time_ms(&end_s, &end_ms);
+  uint16_t elapsed_ms = (end_s - ui_transaction.start_s) * 1000 + end_ms - ui_transaction.start_ms;
+  if (elapsed_ms > ui_worst_commit_ms) {
+    ui_worst_commit_ms = elapsed_ms;
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Slowest UI update so far: %d ms (changes 0x%x)", elapsed_ms, changes);
+  }
 }
 
 /*
  * Battery icon callback handler
  */
 void battery_layer_update_callback(Layer *layer, GContext *ctx) {
-
-  graphics_context_set_compositing_mode(ctx, GCompOpSet);
-
-  if (!battery_plugged) {
-    graphics_draw_bitmap_in_rect(ctx, icon_battery, GRect(0, 0, BATTERY_IMAGE_WIDTH, BATTERY_IMAGE_HEIGHT));
-    graphics_context_set_stroke_color(ctx, GColorBlack);
-    if (battery_level >= 40)
-        graphics_context_set_fill_color(ctx, GColorGreen);
-    else if (battery_level >= 20)
-        graphics_context_set_fill_color(ctx, GColorYellow);
-    else
-        graphics_context_set_fill_color(ctx, GColorRed);
-    int height = (uint8_t)((battery_level / 100.0) * 10.0);
-    graphics_fill_rect(ctx, GRect(2, 13 - height, 4, height), 0, GCornerNone);
-  } else {
-    graphics_draw_bitmap_in_rect(ctx, icon_battery_charge, GRect(0, 0, BATTERY_IMAGE_WIDTH, BATTERY_IMAGE_HEIGHT));
-  }
+  graphics_context_set_compositing_mode(ctx, PBL_IF_COLOR_ELSE(GCompOpSet, GCompOpAssign));
+  graphics_draw_bitmap_in_rect(ctx, battery_renderer_get_bitmap(&battery_renderer), GRect(0, 0, BATTERY_IMAGE_WIDTH, BATTERY_IMAGE_HEIGHT));
 }
 
 void recheck_bluetooth(void *data) {
+    energy_count(ENERGY_TIMER_WAKEUP, 1);
     app_timer_cancel(recheck_bluetooth_timer);
     if (!bluetooth_connection_service_peek()) {
       fail_mode();
@@ -526,68 +781,117 @@ void bluetooth_connection_handler(bool connected) {
   }
 }
 
-static GPoint get_frame_location(int buffer, int angle) {
-  unsigned int x = 0;
-  unsigned int y = 0;
-  int32_t xsize = (SCREEN_WIDTH - 2 * buffer) / 2;
-  int32_t ysize = (SCREEN_HEIGHT - 2 * buffer) / 2;
-  unsigned int angle0 = 182 * angle;
-  
-  if ((angle >= 228) && (angle < 316)) {
-    x = buffer;
-    y = YCENTER + (ysize * cos_lookup(angle0) / sin_lookup(angle0)) ;
-  } else if ((angle > 45) && (angle < 136)) {
-    x = 144 - buffer;
-    y = YCENTER - (ysize * cos_lookup(angle0) / sin_lookup(angle0)) ;
-  } else if ((angle >= 136) && (angle < 228)) {
-    x = XCENTER - (xsize * sin_lookup(angle0) / cos_lookup(angle0));
-    y = 168 - buffer;
-  } else {
-    x = XCENTER + (xsize * sin_lookup(angle0) / cos_lookup(angle0));
-    y = buffer;
+#ifdef OVERDRAW
+static void account_glyph(Layer *parent, GRect frame) {
+  GRect parent_frame = layer_get_frame(parent);
+  frame.origin.x += parent_frame.origin.x;
+  frame.origin.y += parent_frame.origin.y;
+  overdraw_account_rect(frame);
+}
+
+// areas the SDK draws for a frame; every layer is redrawn on every frame
+static void account_frame() {
+  overdraw_set_source(OVERDRAW_SOURCE_FILL);
+  overdraw_account_rect(GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+
+  // whole layer frames, transparent glyph pixels are skipped by GCompOpSet but still visited;
+  // time glyphs account their own spans
+  overdraw_set_source(OVERDRAW_SOURCE_GLYPHS);
+  for (int i = 0; i < NUMBER_OF_DATE_SLOTS; i++) {
+    if (date_slots[i].slot.state != EMPTY_SLOT) account_glyph(date_layer, date_slots[i].frame);
   }
-  return (GPoint) { .x = x, .y = y };
+  if (slash_item.loaded) account_glyph(date_layer, slash_item.frame);
+  if (day_item.loaded) overdraw_account_rect(day_item.frame);
+  overdraw_account_rect(layer_get_frame(battery_layer));
 }
+#endif
 
 static void update_root_layer(Layer *layer, GContext *ctx) {
-  graphics_context_set_fill_color(ctx, GColorBlack);
+  profiler_frame_begin();
+  telemetry_frame_begin();
+  energy_count(ENERGY_REDRAW, 1);
+
+  graphics_context_set_fill_color(ctx, theme.background);
   graphics_fill_rect(ctx, GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT), 0, GCornerNone);
 
-  struct tm *tick_time;
-  time_t current_time = time(NULL);
-  tick_time = localtime(&current_time);
- 
-  unsigned int hour_angle = (tick_time->tm_hour % 12) * 30 + (tick_time->tm_min / 2);
-  graphics_context_set_fill_color(ctx, hour_color);
-  GPoint hloc = get_frame_location(HOUR_BUFFER, hour_angle);
-  graphics_fill_circle(ctx, hloc, HOUR_SIZE);
-  graphics_context_set_stroke_color(ctx, hour_color);
-  //graphics_context_set_stroke_width(ctx, 3);
-  graphics_draw_line(ctx, (GPoint){XCENTER, YCENTER}, hloc);
-  graphics_context_set_stroke_color(ctx, GColorBlack);
-  //graphics_context_set_stroke_width(ctx, 1);
-  graphics_draw_line(ctx, hloc, (GPoint){2 * hloc.x - XCENTER, 2 * hloc.y - YCENTER}); 
+  // hands of the last committed tick, only recomputed while they sweep
+  GPoint hloc = time_state.hour_location;
+  GPoint mloc = time_state.minute_location;
+  int hour_angle = time_state.hour_angle;
+  int minute_angle = time_state.minute_angle;
+  if (hand_sweep.progress < ANIMATOR_PROGRESS_MAX) {
+    hour_angle = sweep_angle(hand_sweep.from_hour_angle, hour_angle, hand_sweep.progress);
+    minute_angle = sweep_angle(hand_sweep.from_minute_angle, minute_angle, hand_sweep.progress);
+    hloc = time_state_hand_location(&time_layout, HOUR_BUFFER, hour_angle);
+    mloc = time_state_hand_location(&time_layout, MINUTE_BUFFER, minute_angle);
+  }
+  hand_sweep.hour_angle = hour_angle;
+  hand_sweep.minute_angle = minute_angle;
+
+  GPoint center = (GPoint){XCENTER, YCENTER};
+
+  // hands are written straight into the framebuffer, spans account themselves
+  overdraw_set_source(OVERDRAW_SOURCE_HANDS);
+  const RenderTierPolicy *policy = render_tier_policy(render_tier);
+  int hand_width = policy->thin_hands ? 1 : HAND_WIDTH;
+  RasterTarget target;
+  if (raster_begin(&target, ctx)) {
+    if (policy->hand_discs) raster_fill_circle(&target, hloc, HOUR_SIZE, theme.hour_hand);
+    raster_line(&target, center, hloc, hand_width, theme.hour_hand);
+    if (policy->hand_grooves) raster_line(&target, hloc, (GPoint){2 * hloc.x - XCENTER, 2 * hloc.y - YCENTER}, 1, theme.hand_groove);
+
+    if (policy->hand_discs) raster_fill_circle(&target, mloc, MINUTE_SIZE, theme.minute_hand);
+    raster_line(&target, center, mloc, hand_width, theme.minute_hand);
+    if (policy->hand_grooves) raster_line(&target, mloc, (GPoint){2 * mloc.x - XCENTER, 2 * mloc.y - YCENTER}, 1, theme.hand_groove);
+
+    raster_fill_circle(&target, center, HOUR_SIZE / 3, theme.hour_hand);
+    raster_fill_circle(&target, center, MINUTE_SIZE / 3, theme.minute_hand);
+    raster_end(&target, ctx);
+  }
+
+#ifdef OVERDRAW
+  account_frame();
+#endif
+}
+
+// time_layer sits at the window origin, so layer coordinates are framebuffer coordinates
+static void update_time_layer(Layer *layer, GContext *ctx) {
+  overdraw_set_source(OVERDRAW_SOURCE_GLYPHS);
+  for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
+    TimeSlot *time_slot = &time_slots[i];
+    if (time_slot->state == EMPTY_SLOT) {
+      continue;
+    }
+    // the glyph's bottom rows first, so growing the height slides the digit down into place
+    GRect frame = frame_for_time_slot(time_slot);
+    frame.size.h = time_slot->shown_height;
+    GPoint origin = GPoint(frame.origin.x, frame.origin.y + frame.size.h - TIME_IMAGE_HEIGHT);
+    glyph_draw(ctx, time_slot->glyph, origin, frame, theme.digits, theme.inverted);
+  }
+}
 
-  
-  unsigned int minute_angle = tick_time->tm_min * 6;
-  graphics_context_set_fill_color(ctx, minute_color);
-  GPoint mloc = get_frame_location(MINUTE_BUFFER, minute_angle);
-  graphics_fill_circle(ctx, mloc, MINUTE_SIZE);
-  graphics_context_set_stroke_color(ctx, minute_color);
-  //graphics_context_set_stroke_width(ctx, 3);
-  graphics_draw_line(ctx, (GPoint){XCENTER, YCENTER}, mloc);
-  graphics_context_set_stroke_color(ctx, GColorBlack);
-  //graphics_context_set_stroke_width(ctx, 1);
-  graphics_draw_line(ctx, mloc, (GPoint){2 * mloc.x - XCENTER, 2 * mloc.y - YCENTER}); 
 
-  graphics_context_set_fill_color(ctx, hour_color);
-  graphics_fill_circle(ctx, (GPoint){XCENTER, YCENTER}, HOUR_SIZE / 3);
-  graphics_context_set_fill_color(ctx, minute_color);
-  graphics_fill_circle(ctx, (GPoint){XCENTER, YCENTER}, MINUTE_SIZE / 3);
+#ifdef PROFILE
+// simulated bluetooth events, skipping the 3s recheck
+static void simulate_connection(bool connected) {
+  if (connected) {
+    reset_fail_mode();
+  } else {
+    fail_mode();
+  }
 }
 
+// real handlers driven by the profiler sweep
+static const ProfilerHooks simulation_hooks = {
+  .tick = handle_tick,
+  .battery = handle_battery,
+  .connection = simulate_connection
+};
+#endif
 
 void init() {
+        // resumes this hour's counts before anything is counted
+        energy_init();
 
         // Register callbacks
         app_message_register_inbox_received(inbox_received_callback);
@@ -595,40 +899,22 @@ void init() {
         app_message_register_outbox_failed(outbox_failed_callback);
         app_message_register_outbox_sent(outbox_sent_callback);
 
-        // Open AppMessage
-        app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum());  
+        // Open AppMessage, buffers sized for the config schema rather than the maximum
+        app_message_open(SETTINGS_INBOX_SIZE, SETTINGS_OUTBOX_SIZE + TELEMETRY_OUTBOX_SIZE);
   
-        // Get stored colors
-        #ifdef PBL_COLOR
-        int red, green, blue;
-        if (persist_exists(KEY_MINUTE_COLOR_R)) {
-            red = persist_read_int(KEY_MINUTE_COLOR_R);
-            green = persist_read_int(KEY_MINUTE_COLOR_G);
-	    blue = persist_read_int(KEY_MINUTE_COLOR_B);
-	    minute_color = GColorFromRGB(red, green, blue);
-        } else {
-	    minute_color = MINUTE_COLOR;
-        }
-	if (persist_exists(KEY_HOUR_COLOR_R)) {
-	    red = persist_read_int(KEY_HOUR_COLOR_R);
-	    green = persist_read_int(KEY_HOUR_COLOR_G);
-	    blue = persist_read_int(KEY_HOUR_COLOR_B);  
-	    hour_color = GColorFromRGB(red, green, blue);
-	} else {
-	    hour_color = HOUR_COLOR;
-	}
-	#endif
-    
+        // Get stored settings
+        settings_load(&settings);
+        theme_init(&theme, &settings, false);
+
   window = window_create();
   window_stack_push(window, true /* Animated */);
 
   // Time slots
   for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
-    Slot *time_slot = &time_slots[i];
+    TimeSlot *time_slot = &time_slots[i];
     time_slot->number  = i;
     time_slot->state   = EMPTY_SLOT;
-    time_slot->image_layer = NULL;
-    time_slot->bitmap  = NULL;
+    time_slot->glyph   = NULL;
   }
 
   // Date slots
@@ -641,6 +927,8 @@ void init() {
     date_slot->frame = GRectZero;
   }
 
+  time_state_init(&time_state);
+
   // Root layer
   root_layer = window_get_root_layer(window);
   layer_set_update_proc(root_layer, update_root_layer);
@@ -648,8 +936,12 @@ void init() {
   // Time
   time_layer = layer_create(GRect(0, 0, SCREEN_WIDTH, SCREEN_WIDTH));
   layer_set_clips(time_layer, true);
+  layer_set_update_proc(time_layer, update_time_layer);
   layer_add_child(root_layer, time_layer);
 
+  hour_pulse_layer = effect_layer_create(GRect(0, 0, SCREEN_WIDTH, MARGIN + TIME_IMAGE_HEIGHT));
+  layer_add_child(root_layer, effect_layer_get_layer(hour_pulse_layer));
+
   struct tm *tick_time;
   time_t current_time = time(NULL);
   tick_time = localtime(&current_time);
@@ -662,55 +954,56 @@ void init() {
 
   // Date
   date_layer = NULL;
-  create_date_layer(tick_time);
 
   // Battery status setup
-  icon_battery = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BATTERY);
-  icon_battery_charge = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_CHARGING);
+  battery_renderer_init(&battery_renderer, &theme);
 
   battery_layer = layer_create(GRect(SCREEN_WIDTH-BATTERY_IMAGE_WIDTH-MARGIN-MARGIN,SCREEN_WIDTH+7,BATTERY_IMAGE_WIDTH,BATTERY_IMAGE_HEIGHT));
-  BatteryChargeState initial = battery_state_service_peek();
-  battery_level = initial.charge_percent;
-  battery_plugged = initial.is_plugged;
+  battery_renderer_update(&battery_renderer, battery_state_service_peek());
   layer_set_update_proc(battery_layer, &battery_layer_update_callback);
   layer_add_child(root_layer, battery_layer);
 
-  // Inverter
-  full_inverse_layer = effect_layer_create(GRECT_FULL_WINDOW);
-  effect_layer_add_effect(full_inverse_layer, effect_invert, NULL);
-  inverter_layer = effect_layer_get_layer(full_inverse_layer);
-
   // Display
-  window_set_background_color(window, GColorBlack);
+  window_set_background_color(window, theme.background);
 
-  display_time(tick_time);
-  display_day(tick_time);
-  display_date(tick_time);
-  display_slash();
+  ui_begin_update();
+  ui_transaction.animate = false;
+  ui_stage_time(tick_time);
+  ui_commit_update();
 
   tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
   battery_state_service_subscribe(&handle_battery);
   handle_battery(battery_state_service_peek());
   bluetooth_connection_service_subscribe(&bluetooth_connection_handler);
   bluetooth_connection_handler(bluetooth_connection_service_peek());
+
+  profiler_init(root_layer, &simulation_hooks);
+  telemetry_init(root_layer);
 }
 
 void deinit() {
+  profiler_deinit();
+  telemetry_deinit();
+  energy_deinit();
+  animator_deinit();
+  cancel_prerender();
+
   for (int i = 0; i < NUMBER_OF_TIME_SLOTS; i++) {
-    unload_digit_image_from_slot(&time_slots[i]);
+    unload_time_slot(&time_slots[i]);
   }
   for (int i = 0; i < NUMBER_OF_DATE_SLOTS; i++) {
     unload_digit_image_from_slot(&date_slots[i].slot);
   }
 
-  gbitmap_destroy(icon_battery);
-  gbitmap_destroy(icon_battery_charge);
   layer_destroy(battery_layer);
+  battery_renderer_deinit(&battery_renderer);
 
   unload_day();
   unload_slash();
+  layer_destroy(date_layer);
+  effect_layer_destroy(hour_pulse_layer);
+  hour_pulse = NULL;
   layer_destroy(time_layer);
-  effect_layer_destroy(full_inverse_layer);
   window_destroy(window);
 
 }
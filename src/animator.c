@@ -0,0 +1,138 @@
+#include <pebble.h>
+#include "animator.h"
+#include "energy.h"
+
+typedef struct {
+  AnimatorUpdate *update;
+  void *context;
+  uint32_t start_ms;
+  uint16_t duration_ms;
+} AnimatorTrack;
+
+static AnimatorTrack tracks[ANIMATOR_MAX_TRACKS];
+static AppTimer *frame_timer;
+static uint32_t last_frame_ms;
+static uint8_t overruns;
+static AnimatorStats stats;
+
+// wall clock in ms, wraps after ~49 days which the unsigned differences below tolerate
+static uint32_t now_ms(void) {
+  time_t s;
+  uint16_t ms;
+  time_ms(&s, &ms);
+  return (uint32_t)s * 1000 + ms;
+}
+
+static bool track_active(const AnimatorTrack *track) {
+  return track->update != NULL;
+}
+
+static void track_finish(AnimatorTrack *track) {
+  AnimatorUpdate *update = track->update;
+  track->update = NULL;  // cleared first, the update may start a new animation
+  update(track->context, ANIMATOR_PROGRESS_MAX);
+}
+
+static void frame_callback(void *data);
+
+static void schedule_frame(void) {
+  if (!frame_timer) {
+    frame_timer = app_timer_register(ANIMATOR_FRAME_MS, frame_callback, NULL);
+  }
+}
+
+static void frame_callback(void *data) {
+  frame_timer = NULL;
+  energy_count(ENERGY_TIMER_WAKEUP, 1);
+  uint32_t now = now_ms();
+
+  // the time since the last frame covers rendering it, which happens between timer callbacks
+  uint32_t frame_ms = now - last_frame_ms;
+  last_frame_ms = now;
+  stats.frames++;
+  if (frame_ms > stats.worst_ms) stats.worst_ms = MIN(frame_ms, UINT16_MAX);
+
+  bool shorten = false;
+  if (frame_ms > ANIMATOR_FRAME_BUDGET_MS) {
+    stats.skipped += frame_ms / ANIMATOR_FRAME_MS - 1;
+    if (++overruns >= ANIMATOR_MAX_OVERRUNS) {
+      shorten = true;
+      stats.shortened++;
+    }
+  } else {
+    overruns = 0;
+  }
+
+  bool running = false;
+  for (int i = 0; i < ANIMATOR_MAX_TRACKS; i++) {
+    AnimatorTrack *track = &tracks[i];
+    if (!track_active(track)) {
+      continue;
+    }
+    uint32_t elapsed = now - track->start_ms;
+    if (shorten || elapsed >= track->duration_ms) {
+      track_finish(track);
+    } else {
+      track->update(track->context, elapsed * ANIMATOR_PROGRESS_MAX / track->duration_ms);
+      running = true;
+    }
+  }
+
+  if (running) {
+    schedule_frame();
+  } else {
+    overruns = 0;
+#ifdef PROFILE
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "animator frames=%d skipped=%d worst=%dms shortened=%d",
+      (int)stats.frames, (int)stats.skipped, stats.worst_ms, stats.shortened);
+#endif
+  }
+}
+
+bool animator_start(AnimatorUpdate *update, void *context, uint16_t duration_ms) {
+  AnimatorTrack *free_track = NULL;
+  for (int i = 0; i < ANIMATOR_MAX_TRACKS; i++) {
+    AnimatorTrack *track = &tracks[i];
+    if (track_active(track) && track->update == update && track->context == context) {
+      free_track = track;
+      break;
+    }
+    if (!track_active(track) && !free_track) free_track = track;
+  }
+  if (!free_track) {
+    return false;
+  }
+
+  uint32_t now = now_ms();
+  if (!frame_timer) {
+    last_frame_ms = now;  // idle time before the first frame isn't an overrun
+  }
+  *free_track = (AnimatorTrack) { .update = update, .context = context, .start_ms = now, .duration_ms = MAX(duration_ms, 1) };
+  update(context, 0);
+  schedule_frame();
+  return true;
+}
+
+void animator_finish_all(void) {
+  for (int i = 0; i < ANIMATOR_MAX_TRACKS; i++) {
+    if (track_active(&tracks[i])) track_finish(&tracks[i]);
+  }
+}
+
+void animator_deinit(void) {
+  animator_finish_all();
+  if (frame_timer) {
+    app_timer_cancel(frame_timer);
+    frame_timer = NULL;
+  }
+}
+
+const AnimatorStats *animator_get_stats(void) {
+  return &stats;
+}
+
+uint32_t animator_ease_out(uint32_t progress) {
+  // 1 - (1 - p)^2
+  uint32_t remaining = ANIMATOR_PROGRESS_MAX - progress;
+  return ANIMATOR_PROGRESS_MAX - remaining * remaining / ANIMATOR_PROGRESS_MAX;
+}
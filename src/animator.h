@@ -0,0 +1,45 @@
+#pragma once
+#include <pebble.h>
+
+// Frame-budgeted animation scheduler. All running animations share one
+// AppTimer and are advanced by wall time, not by frame count, so a frame
+// that takes too long makes the next one jump ahead instead of slowing the
+// animation down. After ANIMATOR_MAX_OVERRUNS slow frames in a row the
+// running animations are cut short and jump to their end.
+
+//frames are requested this often while anything is animating (ms)
+#define ANIMATOR_FRAME_MS 33
+//a frame slower than this counts as an overrun (ms)
+#define ANIMATOR_FRAME_BUDGET_MS 50
+//consecutive overruns after which running animations are finished at once
+#define ANIMATOR_MAX_OVERRUNS 2
+//concurrent animations
+#define ANIMATOR_MAX_TRACKS 6
+
+//progress passed to updates, from 0 to ANIMATOR_PROGRESS_MAX (reached exactly once, last)
+#define ANIMATOR_PROGRESS_MAX 1024
+
+typedef void AnimatorUpdate(void *context, uint32_t progress);
+
+// frame statistics of the animations run so far
+typedef struct {
+  uint32_t frames;       // frames requested
+  uint32_t skipped;      // frames that would have been drawn on time but weren't
+  uint16_t worst_ms;     // slowest frame
+  uint16_t shortened;    // times animations were cut short
+} AnimatorStats;
+
+//starts an animation, or restarts it if update/context is already running.
+//false when all tracks are in use, the caller should apply the end state itself
+bool animator_start(AnimatorUpdate *update, void *context, uint16_t duration_ms);
+
+//jumps every running animation to its end, e.g. before applying a new tick
+void animator_finish_all(void);
+
+//finishes everything and stops the timer
+void animator_deinit(void);
+
+const AnimatorStats *animator_get_stats(void);
+
+//progress remapped so the motion starts fast and settles
+uint32_t animator_ease_out(uint32_t progress);
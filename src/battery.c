@@ -0,0 +1,106 @@
+#include <pebble.h>
+#include "battery.h"
+
+// fill bar inside the icon, grows upwards 1px per 10%
+#define BATTERY_BAR_X 2
+#define BATTERY_BAR_BOTTOM 13
+#define BATTERY_BAR_WIDTH 4
+
+// reads a pixel of a resource bitmap as GColor8 argb, whatever its format
+static uint8_t get_argb(GBitmap *bitmap, int y, int x) {
+  uint8_t *row = gbitmap_get_data(bitmap) + y * gbitmap_get_bytes_per_row(bitmap);
+  GColor *palette = gbitmap_get_palette(bitmap);
+
+  switch (gbitmap_get_format(bitmap)) {
+    case GBitmapFormat1Bit: // no palette, least significant bit first
+      return (row[x / 8] >> (x % 8)) & 1 ? GColorWhiteARGB8 : GColorBlackARGB8;
+    case GBitmapFormat1BitPalette: // palettized formats are most significant bit first
+      return palette[(row[x / 8] >> (7 - x % 8)) & 0x1].argb;
+    case GBitmapFormat2BitPalette:
+      return palette[(row[x / 4] >> (6 - 2 * (x % 4))) & 0x3].argb;
+    case GBitmapFormat4BitPalette:
+      return palette[(row[x / 2] >> (4 - 4 * (x % 2))) & 0xF].argb;
+    default:
+      return row[x];
+  }
+}
+
+// sprite sheet format: one GColor8 per byte, or packed bits on black & white platforms
+#define BATTERY_SHEET_FORMAT PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit)
+
+// writes a pixel of the sprite sheet, on 1 bit anything but white ends up black
+static void sheet_put(uint8_t *sprite, int bytes_per_row, int y, int x, uint8_t argb) {
+#ifdef PBL_COLOR
+  sprite[y * bytes_per_row + x] = argb;
+#else
+  uint8_t bit = 1 << (x % 8);
+  if (argb == GColorWhiteARGB8) sprite[y * bytes_per_row + x / 8] |= bit;
+  else sprite[y * bytes_per_row + x / 8] &= ~bit;
+#endif
+}
+
+// copies an icon into a sprite, then inverts it if the theme is inverted
+static void compose_icon(uint8_t *sprite, int bytes_per_row, uint32_t resource_id, bool inverted) {
+  GBitmap *icon = gbitmap_create_with_resource(resource_id);
+  if (inverted) theme_invert_bitmap(icon);
+  for (int y = 0; y < BATTERY_IMAGE_HEIGHT; y++)
+    for (int x = 0; x < BATTERY_IMAGE_WIDTH; x++)
+      sheet_put(sprite, bytes_per_row, y, x, get_argb(icon, y, x));
+  gbitmap_destroy(icon);
+}
+
+void battery_renderer_init(BatteryRenderer *renderer, const Theme *theme) {
+  renderer->sheet = gbitmap_create_blank(GSize(BATTERY_IMAGE_WIDTH, BATTERY_IMAGE_HEIGHT * BATTERY_SPRITE_COUNT), BATTERY_SHEET_FORMAT);
+  uint8_t *data = gbitmap_get_data(renderer->sheet);
+  int bytes_per_row = gbitmap_get_bytes_per_row(renderer->sheet);
+  int sprite_size = bytes_per_row * BATTERY_IMAGE_HEIGHT;
+
+  for (int level = 0; level < BATTERY_LEVEL_SPRITES; level++) {
+    uint8_t *sprite = data + level * sprite_size;
+    compose_icon(sprite, bytes_per_row, RESOURCE_ID_IMAGE_BATTERY, theme->inverted);
+
+    // same thresholds as 40% / 20% of charge
+    GColor8 fill = level >= 4 ? theme->battery_high : level >= 2 ? theme->battery_mid : theme->battery_low;
+    for (int y = BATTERY_BAR_BOTTOM - level; y < BATTERY_BAR_BOTTOM; y++) {
+#ifdef PBL_COLOR
+      memset(&sprite[y * bytes_per_row + BATTERY_BAR_X], fill.argb, BATTERY_BAR_WIDTH);
+#else
+      for (int x = BATTERY_BAR_X; x < BATTERY_BAR_X + BATTERY_BAR_WIDTH; x++) sheet_put(sprite, bytes_per_row, y, x, fill.argb);
+#endif
+    }
+  }
+  compose_icon(data + BATTERY_SPRITE_CHARGING * sprite_size, bytes_per_row, RESOURCE_ID_IMAGE_CHARGING, theme->inverted);
+
+  for (int i = 0; i < BATTERY_SPRITE_COUNT; i++) {
+    renderer->sprites[i] = gbitmap_create_as_sub_bitmap(renderer->sheet,
+      GRect(0, i * BATTERY_IMAGE_HEIGHT, BATTERY_IMAGE_WIDTH, BATTERY_IMAGE_HEIGHT));
+  }
+  renderer->state = BATTERY_SPRITE_CHARGING;
+}
+
+void battery_renderer_deinit(BatteryRenderer *renderer) {
+  for (int i = 0; i < BATTERY_SPRITE_COUNT; i++) {
+    gbitmap_destroy(renderer->sprites[i]);
+    renderer->sprites[i] = NULL;
+  }
+  gbitmap_destroy(renderer->sheet);
+  renderer->sheet = NULL;
+}
+
+bool battery_renderer_update(BatteryRenderer *renderer, BatteryChargeState charge) {
+  // charge_percent only moves in steps of 10, most events don't change the bar
+  uint8_t state = charge.is_plugged ? BATTERY_SPRITE_CHARGING : MIN(charge.charge_percent / 10, BATTERY_LEVEL_SPRITES - 1);
+  if (state == renderer->state) {
+    return false;
+  }
+  renderer->state = state;
+  return true;
+}
+
+void battery_renderer_invert(BatteryRenderer *renderer) {
+  theme_invert_bitmap(renderer->sheet);
+}
+
+GBitmap *battery_renderer_get_bitmap(BatteryRenderer *renderer) {
+  return renderer->sprites[renderer->state];
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <pebble.h>
+#include "theme.h"
+
+#define BATTERY_IMAGE_WIDTH 8
+#define BATTERY_IMAGE_HEIGHT 15
+
+// 11 fill levels (0%, 10%, ... 100%) plus the charging icon
+#define BATTERY_LEVEL_SPRITES 11
+#define BATTERY_SPRITE_CHARGING BATTERY_LEVEL_SPRITES
+#define BATTERY_SPRITE_COUNT (BATTERY_LEVEL_SPRITES + 1)
+
+// battery icon pre-composed once for every state it can show
+typedef struct {
+  GBitmap *sheet;                          // all sprites stacked vertically
+  GBitmap *sprites[BATTERY_SPRITE_COUNT];  // sub-bitmaps of sheet
+  uint8_t  state;                          // sprite currently shown
+} BatteryRenderer;
+
+//composes all sprites in the theme colors
+void battery_renderer_init(BatteryRenderer *renderer, const Theme *theme);
+
+//frees sprites
+void battery_renderer_deinit(BatteryRenderer *renderer);
+
+//selects the sprite for a charge state; returns true if the visible sprite changed
+bool battery_renderer_update(BatteryRenderer *renderer, BatteryChargeState charge);
+
+//flips all sprites between normal and inverted theme colors
+void battery_renderer_invert(BatteryRenderer *renderer);
+
+//bitmap to draw for the current state
+GBitmap *battery_renderer_get_bitmap(BatteryRenderer *renderer);
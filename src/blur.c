@@ -1,31 +1,29 @@
 #include <pebble.h>
 
 #include "effects.h"
+#include "overdraw.h"
 
 #ifdef PBL_COLOR
 static void blur_(uint8_t *bitmap_data, int bytes_per_row, GRect position, uint16_t line, uint8_t *dest, uint8_t radius){
   uint8_t (*fb_a)[bytes_per_row] = (uint8_t (*)[bytes_per_row])bitmap_data;
   uint16_t total[3] = {0,0,0};
-  uint8_t  nb_points = 0;
-  GPoint p = {0,0};
-  for (uint16_t x = 0; x < position.size.w; ++x) {
+  // rows of the kernel inside position, the columns are cut the same way below
+  int top = MAX(0, line - radius);
+  int bottom = MIN(position.size.h - 1, line + radius);
+  for (int x = 0; x < position.size.w; ++x) {
     total[0] = total[1] = total[2] = 0;
-    nb_points = 0;
-    p.y = position.origin.y + line - radius;
-    for (uint8_t ky = 0; ky <= 2*radius; ++ky){
-      p.x = position.origin.x + x - radius;
-      for (uint8_t kx = 0; kx <= 2*radius; ++kx){
-        if(grect_contains_point(&position, &p)){
-          GColor8 color = (GColor8)fb_a[p.y][p.x];
-          total[0] += color.r;
-          total[1] += color.g;
-          total[2] += color.b;
-          nb_points++;
-        }
-        p.x++;
+    int left = MAX(0, x - radius);
+    int right = MIN(position.size.w - 1, x + radius);
+    for (int ky = top; ky <= bottom; ++ky){
+      uint8_t *row = &fb_a[position.origin.y + ky][position.origin.x];
+      for (int kx = left; kx <= right; ++kx){
+        GColor8 color = (GColor8)row[kx];
+        total[0] += color.r;
+        total[1] += color.g;
+        total[2] += color.b;
       }
-      p.y++;
     }
+    uint16_t nb_points = (bottom - top + 1) * (right - left + 1);
     total[0] = (total[0] * 0x55) / nb_points;
     total[1] = (total[1] * 0x55) / nb_points;
     total[2] = (total[2] * 0x55) / nb_points;
@@ -34,24 +32,30 @@ static void blur_(uint8_t *bitmap_data, int bytes_per_row, GRect position, uint1
 }
 #endif
 
-void effect_blur(GContext* ctx,  GRect position, void* param){
 #ifdef PBL_COLOR
+// blurs the on screen part of position through buffer, which holds radius + 1 rows of its width
+static void blur_rect(GContext* ctx, GRect position, uint8_t radius, uint8_t *buffer){
   //capturing framebuffer bitmap
   GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (!fb) return;
   uint8_t *bitmap_data =  gbitmap_get_data(fb);
   int bytes_per_row = gbitmap_get_bytes_per_row(fb);
 
-  
-  
-  uint8_t radius = (uint8_t)(uint32_t)param; // Not very elegant... sorry
+  GRect bounds = gbitmap_get_bounds(fb);
+  grect_clip(&position, &bounds);
+  if (position.size.w <= 0 || position.size.h <= 0) {
+    graphics_release_frame_buffer(ctx, fb);
+    return;
+  }
+  // the rows kept in buffer have to fit in position
+  radius = MIN(radius, position.size.h - 1);
+
   uint8_t (*fb_a)[bytes_per_row] = (uint8_t (*)[bytes_per_row])bitmap_data;
   uint16_t offset_x = position.origin.x;
   uint16_t offset_y = position.origin.y;
   uint16_t width    = position.size.w;
   uint16_t height   = position.size.h;
  
-  uint8_t *buffer = malloc(width * (radius + 1));
- 
   uint16_t h=0;
   for(; h<(radius+1); h++){
     blur_(bitmap_data, bytes_per_row, position, h, buffer + h*width, radius);
@@ -59,7 +63,7 @@ void effect_blur(GContext* ctx,  GRect position, void* param){
  
   for(; h<height; h++){
     memcpy(&fb_a[offset_y + h - (radius + 1)][offset_x], buffer, width);
-    memcpy(buffer, buffer + width, radius * width);
+    memmove(buffer, buffer + width, radius * width); // the rows overlap once radius > 1
     blur_(bitmap_data, bytes_per_row, position, h, buffer + radius*width, radius);
   }
 
@@ -68,8 +72,50 @@ void effect_blur(GContext* ctx,  GRect position, void* param){
     memcpy(&fb_a[offset_y + height - (radius + 1) + h][offset_x] , buffer + h*width, width);
   }
   
-  free(buffer);
+  overdraw_account_rect(position);
   
   graphics_release_frame_buffer(ctx, fb);
+}
+#endif
+
+// halved for every quality tier down
+static uint8_t blur_radius(uint8_t radius){
+  return radius ? MAX(1, radius >> effect_get_quality()) : 0;
+}
+
+void effect_blur(GContext* ctx,  GRect position, void* param){
+#ifdef PBL_COLOR
+  uint8_t radius = blur_radius((uint8_t)(uint32_t)param); // Not very elegant... sorry
+  uint8_t *buffer = malloc(position.size.w * (radius + 1));
+  if (!buffer) return;
+  blur_rect(ctx, position, radius, buffer);
+  free(buffer);
 #endif
 }
+
+// scratch rows for the full radius, lower quality tiers use fewer of them
+static bool blur_prepare(Effect *effect, GRect frame){
+#ifdef PBL_COLOR
+  effect->cache = malloc(frame.size.w * (effect->params.blur.radius + 1));
+  return effect->cache != NULL;
+#else
+  return true;
+#endif
+}
+
+static void blur_apply(Effect *effect, GContext* ctx, GRect frame){
+#ifdef PBL_COLOR
+  blur_rect(ctx, frame, blur_radius(effect->params.blur.radius), effect->cache);
+#endif
+}
+
+static void blur_destroy(Effect *effect){
+  free(effect->cache);
+  effect->cache = NULL;
+}
+
+const EffectType effect_type_blur = {
+  .prepare = blur_prepare,
+  .apply = blur_apply,
+  .destroy = blur_destroy,
+};
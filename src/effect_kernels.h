@@ -0,0 +1,355 @@
+// Effect kernels, compiled once per framebuffer format by effects.c.
+// No include guard on purpose: before each inclusion effects.c defines
+//
+//   KERNEL(name)         name of the instance for this format
+//   PIXEL_GET(fb, y, x)  reads a pixel
+//   PIXEL_SET(fb, y, x, color)  writes a pixel
+//   PIXEL_BITS           8 (one GColor8 per byte) or 1 (packed black & white)
+//   PIXEL_BLACK, PIXEL_WHITE
+//   PIXEL_INVERT(color)  what effect_invert turns a pixel into
+//   PIXEL_COLOR(gcolor)  a GColor as a pixel value of this format
+//
+// so no kernel ever branches on the format inside its loops. Kernels under
+// PIXEL_BITS == 8 have packed 1-bit counterparts in effects.c that work a
+// byte or a word of pixels at a time.
+// Everything is #undef'd at the bottom, ready for the next format.
+
+#if PIXEL_BITS == 8
+// inverter effect.
+static void KERNEL(invert)(BitmapInfo *fb, GRect position, void *param) {
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++)
+      PIXEL_SET(fb, y, x, PIXEL_INVERT(PIXEL_GET(fb, y, x)));
+}
+
+// invert black and white only (leaves all other colors intact).
+static void KERNEL(invert_bw_only)(BitmapInfo *fb, GRect position, void *param) {
+  uint8_t pixel;
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++) {
+      pixel = PIXEL_GET(fb, y, x);
+      if (pixel == PIXEL_BLACK)
+        PIXEL_SET(fb, y, x, PIXEL_WHITE);
+      else if (pixel == PIXEL_WHITE)
+        PIXEL_SET(fb, y, x, PIXEL_BLACK);
+    }
+}
+
+// colorize effect - given a target color, replace it with a new color
+static void KERNEL(colorize)(BitmapInfo *fb, GRect position, void *param) {
+  EffectColorpair *paint = (EffectColorpair *)param;
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++)
+      if (PIXEL_GET(fb, y, x) == paint->firstColor.argb)
+        PIXEL_SET(fb, y, x, paint->secondColor.argb);
+}
+
+// colorswap effect - swaps two colors in a given area
+static void KERNEL(colorswap)(BitmapInfo *fb, GRect position, void *param) {
+  EffectColorpair *swap = (EffectColorpair *)param;
+  uint8_t pixel;
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++) {
+      pixel = PIXEL_GET(fb, y, x);
+      if (pixel == swap->firstColor.argb)
+        PIXEL_SET(fb, y, x, swap->secondColor.argb);
+      else if (pixel == swap->secondColor.argb)
+        PIXEL_SET(fb, y, x, swap->firstColor.argb);
+    }
+}
+
+// invert brightness of colors through a table indexed by the rgb bits
+static void KERNEL(invert_brightness)(BitmapInfo *fb, GRect position, void *param) {
+  const uint8_t *table = invert_brightness_table();
+  uint8_t pixel;
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++) {
+      pixel = PIXEL_GET(fb, y, x);
+      if (pixel != GColorBlackARGB8 && pixel != GColorWhiteARGB8)
+        PIXEL_SET(fb, y, x, table[pixel & 0x3F]);
+    }
+}
+#endif
+
+#if PIXEL_BITS == 8
+// vertical mirror effect.
+static void KERNEL(mirror_vertical)(BitmapInfo *fb, GRect position, void *param) {
+  uint8_t temp_pixel;
+  mirror_span(fb->frame.origin.y, fb->frame.size.h, &position.origin.y, &position.size.h);
+  for (int y = 0; y < position.size.h / 2 ; y++)
+     for (int x = 0; x < position.size.w; x++){
+        temp_pixel = PIXEL_GET(fb, y + position.origin.y, x + position.origin.x);
+        PIXEL_SET(fb, y + position.origin.y, x + position.origin.x, PIXEL_GET(fb, position.origin.y + position.size.h - y - 2, x + position.origin.x));
+        PIXEL_SET(fb, position.origin.y + position.size.h - y - 2, x + position.origin.x, temp_pixel);
+     }
+}
+
+// horizontal mirror effect.
+static void KERNEL(mirror_horizontal)(BitmapInfo *fb, GRect position, void *param) {
+  uint8_t temp_pixel;
+  mirror_span(fb->frame.origin.x, fb->frame.size.w, &position.origin.x, &position.size.w);
+  for (int y = 0; y < position.size.h; y++)
+     for (int x = 0; x < position.size.w / 2; x++){
+        temp_pixel = PIXEL_GET(fb, y + position.origin.y, x + position.origin.x);
+        PIXEL_SET(fb, y + position.origin.y, x + position.origin.x, PIXEL_GET(fb, y + position.origin.y, position.origin.x + position.size.w - x - 2));
+        PIXEL_SET(fb, y + position.origin.y, position.origin.x + position.size.w - x - 2, temp_pixel);
+     }
+}
+
+#endif
+
+// Rotate 90 degrees
+static void KERNEL(rotate_90_degrees)(BitmapInfo *fb, GRect position, void *param) {
+  bool right = (bool)param;
+  int qtr, xCn, yCn;
+  uint8_t temp_pixel;
+  xCn= fb->frame.origin.x + fb->frame.size.w /2;
+  yCn= fb->frame.origin.y + fb->frame.size.h /2;
+  qtr=fb->frame.size.w;
+  if (fb->frame.size.h < qtr)
+    qtr= fb->frame.size.h;
+  qtr= qtr/2;
+  // every pixel moves through all four quadrants, so only the square around the
+  // centre that position holds on every side can turn
+  CentreReach reach = centre_reach(position, yCn, xCn);
+  qtr = MIN(qtr, MIN(MIN(-reach.y_min, reach.y_max), MIN(-reach.x_min, reach.x_max)) + 1);
+
+  for (int c1 = 0; c1 < qtr; c1++)
+    for (int c2 = 1; c2 < qtr; c2++){
+      temp_pixel = PIXEL_GET(fb, yCn +c1, xCn +c2);
+      if (right){
+        PIXEL_SET(fb, yCn +c1, xCn +c2, PIXEL_GET(fb, yCn -c2, xCn +c1));
+        PIXEL_SET(fb, yCn -c2, xCn +c1, PIXEL_GET(fb, yCn -c1, xCn -c2));
+        PIXEL_SET(fb, yCn -c1, xCn -c2, PIXEL_GET(fb, yCn +c2, xCn -c1));
+        PIXEL_SET(fb, yCn +c2, xCn -c1, temp_pixel);
+      }
+      else{
+        PIXEL_SET(fb, yCn +c1, xCn +c2, PIXEL_GET(fb, yCn +c2, xCn -c1));
+        PIXEL_SET(fb, yCn +c2, xCn -c1, PIXEL_GET(fb, yCn -c1, xCn -c2));
+        PIXEL_SET(fb, yCn -c1, xCn -c2, PIXEL_GET(fb, yCn -c2, xCn +c1));
+        PIXEL_SET(fb, yCn -c2, xCn +c1, temp_pixel);
+      }
+     }
+}
+
+// Zoom effect.
+static void KERNEL(zoom)(BitmapInfo *fb, GRect position, void *param) {
+  int xCn, yCn;
+  uint8_t Y1,X1, ratioY, ratioX;
+  xCn= fb->frame.origin.x + fb->frame.size.w /2;
+  yCn= fb->frame.origin.y + fb->frame.size.h /2;
+  CentreReach reach = centre_reach(position, yCn, xCn);
+
+  ratioY= (int32_t)param >>8 & 0xFF;
+  ratioX= (int32_t)param & 0xFF;
+
+  // reaching as far from the centre on both sides keeps every read and write inside the frame
+  int ry = (fb->frame.size.h - 1) / 2;
+  int rx = (fb->frame.size.w - 1) / 2;
+  // source of every distance from the centre, zooming out reads no further than the edge
+  uint8_t source_y[ry + 1], source_x[rx + 1];
+  for (int i = 0; i <= ry; i++) source_y[i] = MIN((i<<4) /ratioY, ry);
+  for (int i = 0; i <= rx; i++) source_x[i] = MIN((i<<4) /ratioX, rx);
+
+  for (int y = 0; y <= ry; y++)
+    for (int x = 0; x <= rx; x++)
+    {
+      //yS,xS scan source: centre to out or out to centre
+      int yS = (ratioY>16) ? ry- y: y; 
+      int xS = (ratioX>16) ? rx- x: x;
+      Y1= source_y[yS];
+      X1= source_x[xS];
+      if (REACHES(reach, yS, xS) && REACHES(reach, Y1, X1))
+        PIXEL_SET(fb, yCn +yS, xCn +xS, PIXEL_GET(fb, yCn +Y1, xCn +X1)); 
+      if (REACHES(reach, yS, -xS) && REACHES(reach, Y1, -X1))
+        PIXEL_SET(fb, yCn +yS, xCn -xS, PIXEL_GET(fb, yCn +Y1, xCn -X1));
+      if (REACHES(reach, -yS, xS) && REACHES(reach, -Y1, X1))
+        PIXEL_SET(fb, yCn -yS, xCn +xS, PIXEL_GET(fb, yCn -Y1, xCn +X1));
+      if (REACHES(reach, -yS, -xS) && REACHES(reach, -Y1, -X1))
+        PIXEL_SET(fb, yCn -yS, xCn -xS, PIXEL_GET(fb, yCn -Y1, xCn -X1));
+    }
+}
+
+// Lens effect.
+static void KERNEL(lens)(BitmapInfo *fb, GRect position, void *param) {
+  LensRequest *lens = (LensRequest *)param;
+  uint8_t d,r;
+  int xCn, yCn;
+  int step = lens->step;
+
+  xCn= fb->frame.origin.x + fb->frame.size.w /2;
+  yCn= fb->frame.origin.y + fb->frame.size.h /2;
+  d=fb->frame.size.w;
+  if (fb->frame.size.h < d)
+    d= fb->frame.size.h;
+  CentreReach reach = centre_reach(position, yCn, xCn);
+  r= d/2; // radius of lens
+  
+  for (int y = r; y >= 0; y -= step)
+    for (int x = r; x >= 0; x -= step)
+      if (x*x+y*y < r*r)
+      {
+        // a lens never reads from outside its own disc
+        int Y1= MIN(lens->offsets[y], r - 1);
+        int X1= MIN(lens->offsets[x], r - 1);
+        // the rest of the block is shifted along with its first pixel
+        for (int by = 0; by < step && by <= y; by++)
+          for (int bx = 0; bx < step && bx <= x; bx++) {
+            int ty = y - by, tx = x - bx, sy = Y1 - by, sx = X1 - bx;
+            if (REACHES(reach, ty, tx) && REACHES(reach, sy, sx))
+              PIXEL_SET(fb, yCn +ty, xCn +tx, PIXEL_GET(fb, yCn +sy, xCn +sx)); 
+            if (REACHES(reach, ty, -tx) && REACHES(reach, sy, -sx))
+              PIXEL_SET(fb, yCn +ty, xCn -tx, PIXEL_GET(fb, yCn +sy, xCn -sx));
+            if (REACHES(reach, -ty, tx) && REACHES(reach, -sy, sx))
+              PIXEL_SET(fb, yCn -ty, xCn +tx, PIXEL_GET(fb, yCn -sy, xCn +sx));
+            if (REACHES(reach, -ty, -tx) && REACHES(reach, -sy, -sx))
+              PIXEL_SET(fb, yCn -ty, xCn -tx, PIXEL_GET(fb, yCn -sy, xCn -sx));
+          }
+      }
+}
+
+#if PIXEL_BITS == 8
+// mask effect, replaces pixels of the mask colors with the background bitmap
+static void KERNEL(mask)(BitmapInfo *fb, GRect position, void *param) {
+  EffectMask *mask = (EffectMask *)param;
+
+  //background bitmap can be of any format, read through the generic get_pixel
+  BitmapInfo bg_bitmap_info;
+  bg_bitmap_info.bitmap = mask->bitmap_background;
+  bg_bitmap_info.bitmap_data =  gbitmap_get_data(mask->bitmap_background);
+  bg_bitmap_info.bytes_per_row =  gbitmap_get_bytes_per_row(mask->bitmap_background);
+  bg_bitmap_info.bitmap_format = gbitmap_get_format(mask->bitmap_background);
+
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++)
+      if (gcolor_contains(mask->mask_colors, (GColor)PIXEL_GET(fb, y, x))) // if array of mask colors matches current screen pixel color:
+        // getting pixel from background bitmap (adjusted to pallette by PalColor function because palette of bg bitmap and framebuffer may differ)
+        PIXEL_SET(fb, y, x, PalColor(get_pixel(bg_bitmap_info, y, x), bg_bitmap_info.bitmap_format, fb->bitmap_format));
+}
+
+#endif
+
+// plots one pixel of a long shadow line, see KERNEL(line)
+static inline void KERNEL(line_plot)(BitmapInfo *fb, int y, int x, uint8_t *draw_color, uint8_t skip_color, uint8_t *visited) {
+  uint8_t pixel = PIXEL_GET(fb, y, x);
+#if PIXEL_BITS == 8 // drawing pixel if it is not of original color or already drawn color
+  if (pixel != skip_color && pixel != *draw_color) PIXEL_SET(fb, y, x, *draw_color);
+#else // first check if pixel isn't already marked as set in user-defined array
+  if (((visited[y*20 + x/8] >> (x % 8)) & 1) != 1) {
+    if (pixel != skip_color) PIXEL_SET(fb, y, x, *draw_color); // if pixel isn't of original color - set it
+    *draw_color = 1 - *draw_color; // revers pixel for "lined" effect
+    visited[y*20 + x/8] |= 1 << (x % 8);
+  }
+#endif
+}
+
+// THE EXTREMELY FAST LINE ALGORITHM Variation E (Addition Fixed Point PreCalc Small Display)
+// Small Display (256x256) resolution.
+// based on algorythm by Po-Han Lin at http://www.edepot.com
+// The line starts on screen, so the part of it on screen is a run of its first steps:
+// their number is worked out before plotting instead of checking every pixel.
+static void KERNEL(line)(BitmapInfo *fb, int y, int x, int y2, int x2, uint8_t draw_color, uint8_t skip_color, uint8_t *visited) {
+  bool yLonger = abs(y2-y) > abs(x2-x);
+  // u runs along the longer axis a pixel per step, v along the other in 8.8 fixed point
+  int u = yLonger ? y : x;
+  int longLen = yLonger ? y2-y : x2-x;
+  int shortLen = yLonger ? x2-x : y2-y;
+  int uStep = longLen < 0 ? -1 : 1;
+  int steps = abs(longLen);
+  int decInc = steps ? shortLen * 256 / steps : 0;
+  int j = 0x80 + (yLonger ? x : y) * 256;
+
+  GRect bounds = fb->bounds;
+  int uMin = yLonger ? bounds.origin.y : bounds.origin.x;
+  int uMax = uMin + (yLonger ? bounds.size.h : bounds.size.w) - 1;
+  int vMin = yLonger ? bounds.origin.x : bounds.origin.y;
+  int vMax = vMin + (yLonger ? bounds.size.w : bounds.size.h) - 1;
+  steps = MIN(steps, uStep > 0 ? uMax - u : u - uMin);
+  if (decInc > 0) steps = MIN(steps, (vMax * 256 + 255 - j) / decInc);
+  else if (decInc < 0) steps = MIN(steps, (j - vMin * 256) / -decInc);
+
+  for (int i = 0; i <= steps; ++i, u += uStep, j += decInc) {
+    if (yLonger) KERNEL(line_plot)(fb, u, j >> 8, &draw_color, skip_color, visited);
+    else KERNEL(line_plot)(fb, j >> 8, u, &draw_color, skip_color, visited);
+  }
+}
+
+// shadow effect.
+static void KERNEL(shadow)(BitmapInfo *fb, GRect position, void *param) {
+  EffectOffset *shadow = (EffectOffset *)param;
+  uint8_t orig_color = PIXEL_COLOR(shadow->orig_color);
+  uint8_t offset_color = PIXEL_COLOR(shadow->offset_color);
+  uint8_t temp_pixel;
+  int shadow_x, shadow_y;
+
+#if PIXEL_BITS == 1
+  // with two colors every pixel not of the original color already has the offset one
+  if (shadow->option != 1) return;
+#endif
+
+  // a short shadow only comes from pixels whose shadow lands on screen
+  GRect area = position;
+  if (shadow->option != 1) {
+    GRect shadowed = fb->bounds;
+    shadowed.origin.x -= shadow->offset_x;
+    shadowed.origin.y -= shadow->offset_y;
+    grect_clip(&area, &shadowed);
+  }
+
+  //looping throughout making shadow
+  for (int y = area.origin.y; y < area.origin.y + area.size.h; y++)
+    for (int x = area.origin.x; x < area.origin.x + area.size.w; x++) {
+      if (PIXEL_GET(fb, y, x) != orig_color) {
+        continue;
+      }
+      shadow_x = x + shadow->offset_x;
+      shadow_y = y + shadow->offset_y;
+
+      if (shadow->option == 1) {
+        KERNEL(line)(fb, y, x, shadow_y, shadow_x, offset_color, orig_color, shadow->aplite_visited);
+      } else {
+        temp_pixel = PIXEL_GET(fb, shadow_y, shadow_x);
+        if (temp_pixel != orig_color && temp_pixel != offset_color) {
+          PIXEL_SET(fb, shadow_y, shadow_x, offset_color);
+        }
+      }
+    }
+}
+
+#if PIXEL_BITS == 8
+// outline effect.
+static void KERNEL(outline)(BitmapInfo *fb, GRect position, void *param) {
+  EffectOffset *outline = &((OutlineRequest *)param)->offset;
+  uint8_t orig_color = PIXEL_COLOR(outline->orig_color);
+  uint8_t offset_color = PIXEL_COLOR(outline->offset_color);
+  int right = fb->bounds.origin.x + fb->bounds.size.w - 1;
+  int bottom = fb->bounds.origin.y + fb->bounds.size.h - 1;
+
+  //loop through pixels from framebuffer
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++)
+    for (int x = position.origin.x; x < position.origin.x + position.size.w; x++) {
+      // only pixels that aren't of the original color get changed, so this one can't change below
+      if (PIXEL_GET(fb, y, x) != orig_color) {
+        continue;
+      }
+      // the offset box around the pixel, cut to the screen
+      int y0 = MAX(y - outline->offset_y, fb->bounds.origin.y), y1 = MIN(y + outline->offset_y, bottom);
+      int x0 = MAX(x - outline->offset_x, fb->bounds.origin.x), x1 = MIN(x + outline->offset_x, right);
+      for (int oy = y0; oy <= y1; oy++)
+        for (int ox = x0; ox <= x1; ox++)
+          if (PIXEL_GET(fb, oy, ox) != orig_color) {
+            PIXEL_SET(fb, oy, ox, offset_color);
+          }
+    }
+}
+
+#endif
+
+#undef KERNEL
+#undef PIXEL_GET
+#undef PIXEL_SET
+#undef PIXEL_BITS
+#undef PIXEL_BLACK
+#undef PIXEL_WHITE
+#undef PIXEL_INVERT
+#undef PIXEL_COLOR
@@ -1,6 +1,9 @@
 #include <pebble.h>
 #include "effect_layer.h"
 #include "effects.h"  
+#include "overdraw.h"
+#include "telemetry.h"
+#include "energy.h"
 
 // Find the offset of parent layer pointer  
 static uint8_t find_parent_offset() {
@@ -21,6 +24,88 @@ static uint8_t find_parent_offset() {
   return i;
 }
 
+static Effect effect_pool[EFFECT_POOL_SIZE];
+static Effect *free_effects;
+
+static Effect* effect_alloc(void) {
+  static bool pool_filled = false;
+  if (!pool_filled) {
+    for (int i = 0; i < EFFECT_POOL_SIZE; ++i) {
+      effect_pool[i].next = free_effects;
+      free_effects = &effect_pool[i];
+    }
+    pool_filled = true;
+  }
+  Effect *effect = free_effects;
+  if (effect) {
+    free_effects = effect->next;
+    memset(effect, 0, sizeof(Effect));
+  }
+  return effect;
+}
+
+// drops the cache, prepare runs again before the next apply
+static void effect_unprepare(Effect *effect) {
+  if (effect->prepared && effect->type->destroy) {
+    effect->type->destroy(effect);
+  }
+  effect->prepared = false;
+}
+
+static void effect_free(Effect *effect) {
+  effect_unprepare(effect);
+  effect->next = free_effects;
+  free_effects = effect;
+}
+
+// brings the cache up to date with the params and frame; false if it can't be built
+static bool effect_prepare(Effect *effect, GRect frame) {
+  if (effect->prepared && !gsize_equal(&effect->prepared_size, &frame.size)) {
+    if (effect->type->on_resize) {
+      effect->type->on_resize(effect, frame);
+      effect->prepared_size = frame.size;
+    } else {
+      effect_unprepare(effect);
+    }
+  }
+  if (!effect->prepared) {
+    if (effect->type->prepare && !effect->type->prepare(effect, frame)) {
+      return false;
+    }
+    effect->prepared = true;
+    effect->prepared_size = frame.size;
+  }
+  return true;
+}
+
+// last effect of the chain, NULL if it is empty
+static Effect* effect_layer_last(EffectLayer *effect_layer) {
+  Effect *effect = effect_layer->effects;
+  while (effect && effect->next) effect = effect->next;
+  return effect;
+}
+
+// steps quality down as soon as the chain runs over budget, and back up
+// only after a run of frames with plenty of headroom
+static void effect_layer_adapt_quality(EffectLayer *effect_layer, uint16_t elapsed_ms) {
+  effect_layer->last_ms = elapsed_ms;
+  if (elapsed_ms > EFFECT_LAYER_BUDGET_MS) {
+    effect_layer->fast_frames = 0;
+    if (effect_layer->quality < EFFECT_QUALITY_COUNT - 1) {
+      ++effect_layer->quality;
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "EffectLayer took %d ms, quality down to %d", elapsed_ms, effect_layer->quality);
+    }
+  } else if (elapsed_ms <= EFFECT_LAYER_BUDGET_MS / 2 && effect_layer->quality > EFFECT_QUALITY_FULL) {
+    if (++effect_layer->fast_frames >= EFFECT_LAYER_RECOVER_FRAMES) {
+      effect_layer->fast_frames = 0;
+      --effect_layer->quality;
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "EffectLayer took %d ms, quality up to %d", elapsed_ms, effect_layer->quality);
+    }
+  } else {
+    effect_layer->fast_frames = 0;
+  }
+}
+
 // on layer update - apply effect
 static void effect_layer_update_proc(Layer *me, GContext* ctx) {
   static uint8_t parent_layer_offset = 0xff;
@@ -38,8 +123,39 @@ static void effect_layer_update_proc(Layer *me, GContext* ctx) {
     layer_frame.origin.y += parent_frame.origin.y;
   }
   
+  // nothing to do for a layer entirely off screen, effects clip partly visible ones themselves
+  Window *window = layer_get_window(me);
+  if (window) {
+    GRect visible = layer_frame;
+    GRect screen = layer_get_bounds(window_get_root_layer(window));
+    grect_clip(&visible, &screen);
+    if (visible.size.w <= 0 || visible.size.h <= 0) return;
+    if (effect_layer->effect_count > 0) energy_count(ENERGY_EFFECT_PIXELS, visible.size.w * visible.size.h);
+  }
+
+  time_t start_s;
+  uint16_t start_ms;
+  time_ms(&start_s, &start_ms);
+  effect_set_quality(effect_layer->quality);
+
   // Applying effects
-  for(uint8_t i=0; effect_layer->effects[i] && i<MAX_EFFECTS;++i) effect_layer->effects[i](ctx, layer_frame, effect_layer->params[i]);
+  uint8_t i = 0;
+  for(Effect *effect = effect_layer->effects; effect; effect = effect->next, ++i) {
+    if (effect_layer->quality == EFFECT_QUALITY_MINIMAL && effect->decorative) continue;
+    if (!effect_prepare(effect, layer_frame)) continue;
+    overdraw_set_source(OVERDRAW_SOURCE_EFFECTS + i);
+    effect->type->apply(effect, ctx, layer_frame);
+  }
+
+  effect_set_quality(EFFECT_QUALITY_FULL);
+  if (effect_layer->effect_count > 0) {
+    time_t end_s;
+    uint16_t end_ms;
+    time_ms(&end_s, &end_ms);
+    uint16_t elapsed_ms = (end_s - start_s) * 1000 + end_ms - start_ms;
+    telemetry_record_effects(elapsed_ms);
+    effect_layer_adapt_quality(effect_layer, elapsed_ms);
+  }
 }  
 
 // create effect layer
@@ -59,6 +175,9 @@ EffectLayer* effect_layer_create(GRect frame) {
 void effect_layer_destroy(EffectLayer *effect_layer) {
   // precaution
   if (effect_layer != NULL && effect_layer->layer != NULL) {
+    while (effect_layer->effect_count > 0) {
+      effect_layer_remove_effect(effect_layer);
+    }
     layer_destroy(effect_layer->layer);  
     effect_layer->layer = NULL;
     effect_layer = NULL;
@@ -78,18 +197,67 @@ void effect_layer_set_frame(EffectLayer *effect_layer, GRect frame) {
 
 //adds effect to the layer
 void effect_layer_add_effect(EffectLayer *effect_layer, effect_cb* effect, void* param) {
-  if(effect_layer->next_effect < MAX_EFFECTS) {
-    effect_layer->effects[effect_layer->next_effect] = effect;
-    effect_layer->params[effect_layer->next_effect] = param;  
-    ++effect_layer->next_effect;
+  EffectParams params = { .callback = { .callback = effect, .param = param } };
+  effect_layer_add(effect_layer, &effect_type_callback, &params);
+}
+
+//adds typed effect to the end of the chain
+Effect* effect_layer_add(EffectLayer *effect_layer, const EffectType *type, const EffectParams *params) {
+  if(effect_layer->effect_count >= MAX_EFFECTS) {
+    return NULL;
+  }
+  Effect *effect = effect_alloc();
+  if (!effect) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "EffectLayer pool of %d effects is exhausted", EFFECT_POOL_SIZE);
+    return NULL;
+  }
+  effect->type = type;
+  effect->params = *params;
+
+  Effect *last = effect_layer_last(effect_layer);
+  if (last) {
+    last->next = effect;
+  } else {
+    effect_layer->effects = effect;
+  }
+  ++effect_layer->effect_count;
+  return effect;
+}
+
+//replaces params, the cache is rebuilt lazily
+void effect_set_params(Effect *effect, const EffectParams *params) {
+  if (memcmp(&effect->params, params, sizeof(EffectParams)) != 0) {
+    effect_unprepare(effect);
+    effect->params = *params;
   }
 }
 
 //removes last added effect
 void effect_layer_remove_effect(EffectLayer *effect_layer) {
-  if(effect_layer->next_effect > 0) {
-    effect_layer->effects[effect_layer->next_effect - 1] = NULL;
-    effect_layer->params[effect_layer->next_effect - 1] = NULL;  
-    --effect_layer->next_effect;
+  Effect *last = effect_layer_last(effect_layer);
+  if (!last) {
+    return;
   }
+  if (last == effect_layer->effects) {
+    effect_layer->effects = NULL;
+  } else {
+    Effect *effect = effect_layer->effects;
+    while (effect->next != last) effect = effect->next;
+    effect->next = NULL;
+  }
+  effect_free(last);
+  --effect_layer->effect_count;
+}
+
+//marks last added effect as decorative
+void effect_layer_set_decorative(EffectLayer *effect_layer) {
+  Effect *last = effect_layer_last(effect_layer);
+  if (last) {
+    last->decorative = true;
+  }
+}
+
+//returns current quality tier
+EffectQuality effect_layer_get_quality(EffectLayer *effect_layer) {
+  return effect_layer->quality;
 }
\ No newline at end of file
@@ -2,15 +2,24 @@
 #include <pebble.h>  
 #include "effects.h"
   
-//number of supported effects on a single effect_layer (must be <= 255)
+//longest chain of effects on a single effect_layer
 #define MAX_EFFECTS 4
+//effects shared by the chains of all layers
+#define EFFECT_POOL_SIZE 8
+
+//time the whole chain of a layer may take before its quality steps down (ms)
+#define EFFECT_LAYER_BUDGET_MS 20
+//consecutive frames under half the budget before quality steps back up
+#define EFFECT_LAYER_RECOVER_FRAMES 8
   
 // structure of effect layer
 typedef struct {
   Layer*      layer;
-  effect_cb*  effects[MAX_EFFECTS];
-  void*       params[MAX_EFFECTS];
-  uint8_t     next_effect;
+  Effect*     effects;      // chain applied in order, drawn from the pool
+  uint8_t     effect_count;
+  uint8_t     quality;      // EffectQuality the chain currently runs at
+  uint8_t     fast_frames;  // consecutive frames with headroom
+  uint16_t    last_ms;      // time the chain took last frame
 } EffectLayer;
 
 
@@ -23,9 +32,21 @@ void effect_layer_destroy(EffectLayer *effect_layer);
 //adds effect for the layer
 void effect_layer_add_effect(EffectLayer *effect_layer, effect_cb* effect, void* param);
 
+//adds an effect of type with a copy of params; NULL if the chain is full or the pool is empty
+Effect* effect_layer_add(EffectLayer *effect_layer, const EffectType *type, const EffectParams *params);
+
+//replaces the params of an effect, its cache is prepared again before the next frame if they differ
+void effect_set_params(Effect *effect, const EffectParams *params);
+
 //removes last added effect
 void effect_layer_remove_effect(EffectLayer *effect_layer);
 
+//marks the last added effect as decorative, the first thing dropped when the layer runs slow
+void effect_layer_set_decorative(EffectLayer *effect_layer);
+
+//quality tier the layer's chain currently runs at
+EffectQuality effect_layer_get_quality(EffectLayer *effect_layer);
+
 //gets layer
 Layer* effect_layer_get_layer(EffectLayer *effect_layer);
 
@@ -1,6 +1,7 @@
 #include <pebble.h>
 #include "effects.h"
 #include "math.h"
+#include "overdraw.h"
   
   
 // { ********* Graphics utility functions (probablu should be seaparated into anothe file?) *********
@@ -8,12 +9,13 @@
   
 // set pixel color at given coordinates 
 void set_pixel(BitmapInfo bitmap_info, int y, int x, uint8_t color) {
+  overdraw_write(x, y);
   
-#ifndef PBL_PLATFORM_APLITE  
+#ifndef PBL_BW  
   if (bitmap_info.bitmap_format == GBitmapFormat1BitPalette) { // for 1bit palette bitmap on Basalt --- verify if it needs to be different
      bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8] ^= (-color ^ bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8]) & (1 << (x % 8)); 
 #else
-  if (bitmap_info.bitmap_format == GBitmapFormat1Bit) { // for 1 bit bitmap on Aplite  --- verify if it needs to be different
+  if (bitmap_info.bitmap_format == GBitmapFormat1Bit) { // for 1 bit bitmap on Aplite and Diorite  --- verify if it needs to be different
      bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8] ^= (-color ^ bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8]) & (1 << (x % 8)); 
 #endif
   } else { // othersise (assuming GBitmapFormat8Bit) going byte-wise
@@ -31,12 +33,13 @@ void set_pixel(BitmapInfo bitmap_info, int y, int x, uint8_t color) {
 
 // get pixel color at given coordinates 
 uint8_t get_pixel(BitmapInfo bitmap_info, int y, int x) {
+  overdraw_read(x, y);
 
-#ifndef PBL_PLATFORM_APLITE  
+#ifndef PBL_BW  
   if (bitmap_info.bitmap_format == GBitmapFormat1BitPalette) { // for 1bit palette bitmap on Basalt shifting left to get correct bit
     return (bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8] << (x % 8)) & 128;
 #else
-  if (bitmap_info.bitmap_format == GBitmapFormat1Bit) { // for 1 bit bitmap on Aplite - shifting right to get bit
+  if (bitmap_info.bitmap_format == GBitmapFormat1Bit) { // for 1 bit bitmap on Aplite and Diorite - shifting right to get bit
     return (bitmap_info.bitmap_data[y*bitmap_info.bytes_per_row + x / 8] >> (x % 8)) & 1;
 #endif
   } else {  // othersise (assuming GBitmapFormat8Bit) going byte-wise
@@ -66,105 +69,48 @@ uint8_t PalColor(uint8_t in_color, GBitmapFormat in_format, GBitmapFormat out_fo
     return in_color;
   }
 }
- 
 
-// THE EXTREMELY FAST LINE ALGORITHM Variation E (Addition Fixed Point PreCalc Small Display)
-// Small Display (256x256) resolution.
-// based on algorythm by Po-Han Lin at http://www.edepot.com
-void set_line(BitmapInfo bitmap_info, int y, int x, int y2, int x2, uint8_t draw_color, uint8_t skip_color, uint8_t *visited) {
-  bool yLonger = false; int shortLen=y2-y; int longLen=x2-x;
-  uint8_t temp_pixel;  int temp_x, temp_y;
-  
-  GRect bounds = gbitmap_get_bounds(bitmap_info.bitmap);
-  
-  if (abs(shortLen)>abs(longLen)) {
-    int swap=shortLen;
-    shortLen=longLen; longLen=swap; yLonger=true;
-  }
-  
-  int decInc;
-  if (longLen==0) decInc=0;
-  else decInc = (shortLen << 8) / longLen;
-
-  if (yLonger) {
-    if (longLen>0) {
-      longLen+=y;
-      for (int j=0x80+(x<<8);y<=longLen;++y) {
-        temp_y = y; temp_x = j >> 8;
-        if (temp_y >=bounds.origin.y && temp_y<bounds.size.h && temp_x >=bounds.origin.x && temp_x < bounds.size.w) {
-          temp_pixel = get_pixel(bitmap_info,  temp_y, temp_x);
-          #ifdef PBL_COLOR // for Basalt drawing pixel if it is not of original color or already drawn color
-            if (temp_pixel != skip_color && temp_pixel != draw_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color);
-          #else
-            if (((visited[temp_y*20 + temp_x/8] >> (temp_x % 8)) & 1) != 1) { // for Aplite first check if pixel isn't already marked as set in user-defined array
-              if (temp_pixel != skip_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color); // if pixel isn't of original color - set it
-              draw_color = 1 - draw_color; // revers pixel for "lined" effect
-              visited[temp_y*20 + temp_x/8] ^= (-1 ^ visited[temp_y*20 + temp_x/8]) & (1 << (temp_x % 8)); // in Aplite - set the bit
-            }
-          #endif
-        }
-        j+=decInc;
-      }
-      return;
-    }
-    longLen+=y;
-    for (int j=0x80+(x<<8);y>=longLen;--y) {
-      temp_y = y; temp_x = j >> 8;
-      if (temp_y >=bounds.origin.y && temp_y<bounds.size.h && temp_x >=bounds.origin.x && temp_x < bounds.size.w) {
-        temp_pixel = get_pixel(bitmap_info,  temp_y, temp_x);
-          #ifdef PBL_COLOR // for Basalt drawing pixel if it is not of original color or already drawn color
-            if (temp_pixel != skip_color && temp_pixel != draw_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color);
-          #else
-            if (((visited[temp_y*20 + temp_x/8] >> (temp_x % 8)) & 1) != 1) { // for Aplite first check if pixel isn't already marked as set in user-defined array
-              if (temp_pixel != skip_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color); // if pixel isn't of original color - set it
-              draw_color = 1 - draw_color; // revers pixel for "lined" effect
-              visited[temp_y*20 + temp_x/8] ^= (-1 ^ visited[temp_y*20 + temp_x/8]) & (1 << (temp_x % 8));
-            }
-          #endif
-      }
-      j-=decInc;
-    }
-    return; 
-  }
+static EffectQuality current_quality;
 
-  if (longLen>0) {
-    longLen+=x;
-    for (int j=0x80+(y<<8);x<=longLen;++x) {
-      temp_y = j >> 8; temp_x =  x;
-      if (temp_y >=bounds.origin.y && temp_y<bounds.size.h && temp_x >=bounds.origin.x && temp_x < bounds.size.w) {
-        temp_pixel = get_pixel(bitmap_info, temp_y, temp_x);
-          #ifdef PBL_COLOR // for Basalt drawing pixel if it is not of original color or already drawn color
-            if (temp_pixel != skip_color && temp_pixel != draw_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color);
-          #else
-            if (((visited[temp_y*20 + temp_x/8] >> (temp_x % 8)) & 1) != 1) { // for Aplite first check if pixel isn't already marked as set in user-defined array
-              if (temp_pixel != skip_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color); // if pixel isn't of original color - set it
-              draw_color = 1 - draw_color; // revers pixel for "lined" effect
-              visited[temp_y*20 + temp_x/8] ^= (-1 ^ visited[temp_y*20 + temp_x/8]) & (1 << (temp_x % 8));
-            }
-          #endif
-      }  
-      j+=decInc;
-    }
-    return;
-  }
-  longLen+=x;
-  for (int j=0x80+(y<<8);x>=longLen;--x) {
-    temp_y = j >> 8; temp_x =  x;
-    if (temp_y >=bounds.origin.y && temp_y<bounds.size.h && temp_x >=bounds.origin.x && temp_x < bounds.size.w) {
-      temp_pixel = get_pixel(bitmap_info, temp_y, temp_x);
-          #ifdef PBL_COLOR // for Basalt drawing pixel if it is not of original color or already drawn color
-            if (temp_pixel != skip_color && temp_pixel != draw_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color);
-          #else
-            if (((visited[temp_y*20 + temp_x/8] >> (temp_x % 8)) & 1) != 1) { // for Aplite first check if pixel isn't already marked as set in user-defined array
-              if (temp_pixel != skip_color) set_pixel(bitmap_info, temp_y, temp_x, draw_color); // if pixel isn't of original color - set it
-              draw_color = 1 - draw_color; // revers pixel for "lined" effect
-              visited[temp_y*20 + temp_x/8] ^= (-1 ^ visited[temp_y*20 + temp_x/8]) & (1 << (temp_x % 8));
-            }
-          #endif
-    }  
-    j-=decInc;
-  }
+EffectQuality effect_get_quality(void) {
+  return current_quality;
+}
+
+void effect_set_quality(EffectQuality quality) {
+  current_quality = quality;
+}
+
+// what effect_lens hands its kernels
+typedef struct {
+  const int16_t *offsets; // source of every row and column, by distance from the center
+  uint8_t step;           // the lens is computed once per step x step block of pixels
+} LensRequest;
+
+// what effect_outline hands its kernels
+typedef struct {
+  EffectOffset offset;
+  uint8_t *dilated;  // 1 bit only: scratch rows, (size.w + 7) / 8 bytes for each row of position
+} OutlineRequest;
+
+// bytes of scratch rows the outline kernels need for frame
+static size_t outline_scratch_size(GRect frame) {
+#if defined(PBL_BW)
+  return frame.size.h * ((frame.size.w + 7) / 8);
+#else
+  return 0;
+#endif
+}
 
+// radius of the lens drawn over position
+static int lens_radius(GRect position) {
+  return MIN(position.size.w, position.size.h) / 2;
+}
+
+// offsets[i] is where the pixel i away from the center of the lens is read from,
+// the same along both axes, radius + 1 entries
+static void lens_offsets(int16_t *offsets, int radius, uint8_t focal, uint8_t object_distance) {
+  for (int i = 0; i <= radius; i++)
+    offsets[i] = my_tan(my_asin(i / (float)focal)) * object_distance;
 }
 
 //determine if array of colors contains specific color  
@@ -181,29 +127,501 @@ bool gcolor_contains(GColor *color_array, GColor pixel_color)  {
 
 //  ********* Graphics utility functions (probablu should be seaparated into anothe file?) ********* }
 
-  
+#if defined(PBL_COLOR)
+// brightness opposites, handcrafted since the color spread is not even (probably subjective and open for improvement)
+static const uint8_t invert_brightness_pairs[][2] = {
+  { GColorOxfordBlueARGB8, GColorCelesteARGB8 },
+  { GColorDukeBlueARGB8, GColorVividCeruleanARGB8 },
+  { GColorBlueARGB8, GColorPictonBlueARGB8 },
+  { GColorDarkGreenARGB8, GColorMintGreenARGB8 },
+  { GColorMidnightGreenARGB8, GColorMediumSpringGreenARGB8 },
+  { GColorCobaltBlueARGB8, GColorCyanARGB8 },
+  { GColorBlueMoonARGB8, GColorElectricBlueARGB8 },
+  { GColorIslamicGreenARGB8, GColorMalachiteARGB8 },
+  { GColorJaegerGreenARGB8, GColorScreaminGreenARGB8 },
+  { GColorTiffanyBlueARGB8, GColorCadetBlueARGB8 },
+  { GColorVividCeruleanARGB8, GColorDukeBlueARGB8 },
+  { GColorGreenARGB8, GColorMayGreenARGB8 },
+  { GColorMalachiteARGB8, GColorIslamicGreenARGB8 },
+  { GColorMediumSpringGreenARGB8, GColorMidnightGreenARGB8 },
+  { GColorCyanARGB8, GColorCobaltBlueARGB8 },
+  { GColorBulgarianRoseARGB8, GColorMelonARGB8 },
+  { GColorImperialPurpleARGB8, GColorRichBrilliantLavenderARGB8 },
+  { GColorIndigoARGB8, GColorLavenderIndigoARGB8 },
+  { GColorElectricUltramarineARGB8, GColorVeryLightBlueARGB8 },
+  { GColorArmyGreenARGB8, GColorBrassARGB8 },
+  { GColorDarkGrayARGB8, GColorLightGrayARGB8 },
+  { GColorLibertyARGB8, GColorBabyBlueEyesARGB8 },
+  { GColorVeryLightBlueARGB8, GColorElectricUltramarineARGB8 },
+  { GColorKellyGreenARGB8, GColorGreenARGB8 },
+  { GColorMayGreenARGB8, GColorMediumAquamarineARGB8 },
+  { GColorCadetBlueARGB8, GColorTiffanyBlueARGB8 },
+  { GColorPictonBlueARGB8, GColorBlueARGB8 },
+  { GColorBrightGreenARGB8, GColorIslamicGreenARGB8 },
+  { GColorScreaminGreenARGB8, GColorKellyGreenARGB8 },
+  { GColorMediumAquamarineARGB8, GColorMayGreenARGB8 },
+  { GColorElectricBlueARGB8, GColorBlueMoonARGB8 },
+  { GColorDarkCandyAppleRedARGB8, GColorMelonARGB8 },
+  { GColorJazzberryJamARGB8, GColorBrilliantRoseARGB8 },
+  { GColorPurpleARGB8, GColorShockingPinkARGB8 },
+  { GColorVividVioletARGB8, GColorPurpureusARGB8 },
+  { GColorWindsorTanARGB8, GColorRoseValeARGB8 },
+  { GColorRoseValeARGB8, GColorWindsorTanARGB8 },
+  { GColorPurpureusARGB8, GColorVividVioletARGB8 },
+  { GColorLavenderIndigoARGB8, GColorIndigoARGB8 },
+  { GColorLimerickARGB8, GColorPastelYellowARGB8 },
+  { GColorBrassARGB8, GColorArmyGreenARGB8 },
+  { GColorLightGrayARGB8, GColorDarkGrayARGB8 },
+  { GColorBabyBlueEyesARGB8, GColorLibertyARGB8 },
+  { GColorSpringBudARGB8, GColorDarkGreenARGB8 },
+  { GColorInchwormARGB8, GColorMidnightGreenARGB8 },
+  { GColorMintGreenARGB8, GColorDarkGreenARGB8 },
+  { GColorCelesteARGB8, GColorOxfordBlueARGB8 },
+  { GColorRedARGB8, GColorSunsetOrangeARGB8 },
+  { GColorFollyARGB8, GColorMelonARGB8 },
+  { GColorFashionMagentaARGB8, GColorMagentaARGB8 },
+  { GColorMagentaARGB8, GColorFashionMagentaARGB8 },
+  { GColorOrangeARGB8, GColorRajahARGB8 },
+  { GColorSunsetOrangeARGB8, GColorRedARGB8 },
+  { GColorBrilliantRoseARGB8, GColorJazzberryJamARGB8 },
+  { GColorShockingPinkARGB8, GColorPurpleARGB8 },
+  { GColorChromeYellowARGB8, GColorWindsorTanARGB8 },
+  { GColorRajahARGB8, GColorOrangeARGB8 },
+  { GColorMelonARGB8, GColorDarkCandyAppleRedARGB8 },
+  { GColorRichBrilliantLavenderARGB8, GColorImperialPurpleARGB8 },
+  { GColorYellowARGB8, GColorChromeYellowARGB8 },
+  { GColorIcterineARGB8, GColorChromeYellowARGB8 },
+  { GColorPastelYellowARGB8, GColorChromeYellowARGB8 },
+};
+
+// lookup table for effect_invert_brightness indexed by the rgb bits, built on first use
+static const uint8_t *invert_brightness_table(void) {
+  static uint8_t table[64];
+  static bool built = false;
+
+  if (!built) {
+    for (int i = 0; i < 64; i++) table[i] = 0xC0 | i; // colors without an opposite stay as they are
+    // walking backwards so the first pair for a color wins, as in the original if-chain
+    for (int i = ARRAY_LENGTH(invert_brightness_pairs) - 1; i >= 0; i--)
+      table[invert_brightness_pairs[i][0] & 0x3F] = invert_brightness_pairs[i][1];
+    built = true;
+  }
+  return table;
+}
+#endif
 
-// inverter effect.
-void effect_invert(GContext* ctx,  GRect position, void* param) {
-  //capturing framebuffer bitmap
+// { ********* Effect kernels, one instance per framebuffer format (see effect_kernels.h) *********
+
+// The geometric kernels (mirror, rotate, zoom, lens) are laid out on fb->frame, the effect's
+// whole rect, but may only touch position, the part of it run_kernel left after clipping.
+// Pixels whose source or destination is clipped away are left as they are.
+
+// offsets from a centre that land inside position
+typedef struct {
+  int y_min, y_max, x_min, x_max;
+} CentreReach;
+
+static inline CentreReach centre_reach(GRect position, int yCn, int xCn) {
+  return (CentreReach){
+    .y_min = position.origin.y - yCn, .y_max = position.origin.y + position.size.h - 1 - yCn,
+    .x_min = position.origin.x - xCn, .x_max = position.origin.x + position.size.w - 1 - xCn
+  };
+}
+
+#define REACHES(reach, dy, dx) \
+  ((dy) >= (reach).y_min && (dy) <= (reach).y_max && (dx) >= (reach).x_min && (dx) <= (reach).x_max)
+
+// a mirror over a frame span reverses its first size - 1 pixels; this narrows the span
+// [*origin, *origin + *size) to the same kind of span mirrored around the frame's axis,
+// covering the pixels whose mirror image also lies in it
+static void mirror_span(int frame_origin, int frame_size, int16_t *origin, int16_t *size) {
+  int sum = 2 * frame_origin + frame_size - 2;  // a pixel and its image add up to this
+  int first = MAX(*origin, sum - (*origin + *size - 1));
+  int last = sum - first;
+  *origin = first;
+  *size = last >= first ? last - first + 2 : 0;
+}
+
+#if defined(PBL_COLOR) && !defined(PBL_ROUND)
+// 8 bit rectangular framebuffer, one byte per pixel
+static inline uint8_t get_8bit(BitmapInfo *fb, int y, int x) {
+  overdraw_read(x, y);
+  return fb->bitmap_data[y*fb->bytes_per_row + x];
+}
+
+static inline void set_8bit(BitmapInfo *fb, int y, int x, uint8_t color) {
+  overdraw_write(x, y);
+  fb->bitmap_data[y*fb->bytes_per_row + x] = color;
+}
+
+#define KERNEL(name) name##_8bit
+#define PIXEL_GET get_8bit
+#define PIXEL_SET set_8bit
+#define PIXEL_BITS 8
+#define PIXEL_BLACK GColorBlackARGB8
+#define PIXEL_WHITE GColorWhiteARGB8
+#define PIXEL_INVERT(c) ((uint8_t)(~(c) | 0xC0))
+#define PIXEL_COLOR(c) ((c).argb)
+#include "effect_kernels.h"
+#define KERNEL_8BIT(name) name##_8bit
+#else
+#define KERNEL_8BIT(name) NULL
+#endif
+
+#if defined(PBL_ROUND)
+// 8 bit circular framebuffer, rows are looked up once per effect instead of once per pixel.
+// run_kernel trims position to the visible rows, but its corners still lie outside the
+// disc and the geometric kernels read mirrored coordinates, so these stay checked
+static GBitmapDataRowInfo round_rows[180];
+
+static inline uint8_t get_round(BitmapInfo *fb, int y, int x) {
+  overdraw_read(x, y);
+  if ((x >= round_rows[y].min_x) && (x <= round_rows[y].max_x))
+    return round_rows[y].data[x];
+  else
+    return -1;
+}
+
+static inline void set_round(BitmapInfo *fb, int y, int x, uint8_t color) {
+  overdraw_write(x, y);
+  if ((x >= round_rows[y].min_x) && (x <= round_rows[y].max_x)) round_rows[y].data[x] = color;
+}
+
+#define KERNEL(name) name##_round
+#define PIXEL_GET get_round
+#define PIXEL_SET set_round
+#define PIXEL_BITS 8
+#define PIXEL_BLACK GColorBlackARGB8
+#define PIXEL_WHITE GColorWhiteARGB8
+#define PIXEL_INVERT(c) ((uint8_t)(~(c) | 0xC0))
+#define PIXEL_COLOR(c) ((c).argb)
+#include "effect_kernels.h"
+#define KERNEL_ROUND(name) name##_round
+#else
+#define KERNEL_ROUND(name) NULL
+#endif
+
+#if defined(PBL_BW)
+// 1 bit framebuffer, 8 pixels per byte with the leftmost pixel in the lowest bit
+static inline uint8_t get_1bit(BitmapInfo *fb, int y, int x) {
+  overdraw_read(x, y);
+  return (fb->bitmap_data[y*fb->bytes_per_row + x / 8] >> (x % 8)) & 1;
+}
+
+static inline void set_1bit(BitmapInfo *fb, int y, int x, uint8_t color) {
+  overdraw_write(x, y);
+  fb->bitmap_data[y*fb->bytes_per_row + x / 8] ^= (-color ^ fb->bitmap_data[y*fb->bytes_per_row + x / 8]) & (1 << (x % 8));
+}
+
+#define KERNEL(name) name##_1bit
+#define PIXEL_GET get_1bit
+#define PIXEL_SET set_1bit
+#define PIXEL_BITS 1
+#define PIXEL_BLACK 0
+#define PIXEL_WHITE 1
+#define PIXEL_INVERT(c) (1 - (c))
+#define PIXEL_COLOR(c) (gcolor_equal((c), GColorWhite) ? 1 : 0)
+#include "effect_kernels.h"
+
+// widest span the packed kernels handle, in bytes
+#define PACKED_SPAN_BYTES 32
+
+// bit-reversed value of every byte
+#define R2(n) n, n + 2*64, n + 1*64, n + 3*64
+#define R4(n) R2(n), R2(n + 2*16), R2(n + 1*16), R2(n + 3*16)
+#define R6(n) R4(n), R4(n + 2*4 ), R4(n + 1*4 ), R4(n + 3*4 )
+static const uint8_t reverse_bits[256] = { R6(0), R6(2), R6(1), R6(3) };
+#undef R2
+#undef R4
+#undef R6
+
+// whether rows of position fit the span buffers, run_kernel has already clipped it
+static bool packed_fits(GRect position) {
+  return (position.size.w + 7) / 8 <= PACKED_SPAN_BYTES;
+}
+
+// copies n pixels of a row starting at x0 into span, pixel x0 ending up in bit 0 of span[0].
+// bits past n are cleared
+static void packed_load(const uint8_t *row, int x0, int n, uint8_t *span) {
+  int shift = x0 % 8;
+  const uint8_t *src = row + x0 / 8;
+  int bytes = (n + 7) / 8;
+
+  for (int i = 0; i < bytes; i++) {
+    uint16_t pair = src[i];
+    if (shift && i * 8 + 8 - shift < n) pair |= src[i + 1] << 8; // only touching bytes inside the span
+    span[i] = pair >> shift;
+  }
+  if (n % 8) span[bytes - 1] &= (1 << (n % 8)) - 1;
+}
+
+// writes n pixels from span back to a row starting at x0, leaving the pixels around them alone
+static void packed_store(uint8_t *row, int x0, int n, const uint8_t *span) {
+  int shift = x0 % 8;
+  uint8_t *dst = row + x0 / 8;
+
+  for (int i = 0; i < (n + 7) / 8; i++) {
+    uint16_t mask = ((1 << MIN(8, n - i * 8)) - 1) << shift;
+    uint16_t bits = (span[i] << shift) & mask;
+    dst[i] = (dst[i] & ~(uint8_t)mask) | (uint8_t)bits;
+    if (mask >> 8) dst[i + 1] = (dst[i + 1] & ~(uint8_t)(mask >> 8)) | (uint8_t)(bits >> 8);
+  }
+}
+
+// ors src moved by shift pixels (positive: towards higher x) into dst
+static void packed_or_shifted(uint8_t *dst, const uint8_t *src, int bytes, int shift) {
+  int byte_shift = abs(shift) / 8, bit_shift = abs(shift) % 8;
+
+  for (int i = 0; i < bytes; i++) {
+    int from = shift > 0 ? i - byte_shift : i + byte_shift;
+    if (shift > 0) {
+      if (from >= 0 && from < bytes) dst[i] |= src[from] << bit_shift;
+      if (bit_shift && from - 1 >= 0 && from - 1 < bytes) dst[i] |= src[from - 1] >> (8 - bit_shift);
+    } else {
+      if (from >= 0 && from < bytes) dst[i] |= src[from] >> bit_shift;
+      if (bit_shift && from + 1 >= 0 && from + 1 < bytes) dst[i] |= src[from + 1] << (8 - bit_shift);
+    }
+  }
+}
+
+// inverter effect, XOR over whole words with masked edge bytes.
+static void invert_1bit(BitmapInfo *fb, GRect position, void *param) {
+  if (!packed_fits(position)) return;
+  overdraw_account_rect(position);
+
+  int x1 = position.origin.x + position.size.w - 1;
+  int first = position.origin.x / 8, last = x1 / 8;
+  uint8_t first_mask = 0xFF << (position.origin.x % 8);
+  uint8_t last_mask = 0xFF >> (7 - x1 % 8);
+
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++) {
+    uint8_t *row = fb->bitmap_data + y * fb->bytes_per_row;
+    if (first == last) {
+      row[first] ^= first_mask & last_mask;
+      continue;
+    }
+    row[first] ^= first_mask;
+    int i = first + 1;
+    // a word at a time through memcpy, which compiles to plain loads and stores at
+    // any -O level without assuming the row's alignment or breaking aliasing rules
+    for (; i + 4 <= last; i += 4) {
+      uint32_t word;
+      memcpy(&word, &row[i], sizeof(word));
+      word = ~word;
+      memcpy(&row[i], &word, sizeof(word));
+    }
+    for (; i < last; i++) row[i] ^= 0xFF;
+    row[last] ^= last_mask;
+  }
+}
+
+// invert black and white only - on a black and white screen that is all of it.
+static void invert_bw_only_1bit(BitmapInfo *fb, GRect position, void *param) {
+  invert_1bit(fb, position, param);
+}
+
+// vertical mirror effect, swapping rows a byte at a time.
+static void mirror_vertical_1bit(BitmapInfo *fb, GRect position, void *param) {
+  mirror_span(fb->frame.origin.y, fb->frame.size.h, &position.origin.y, &position.size.h);
+  if (!packed_fits(position)) return;
+  overdraw_account_rect(position);
+
+  uint8_t top[PACKED_SPAN_BYTES], bottom[PACKED_SPAN_BYTES];
+  for (int y = 0; y < position.size.h / 2; y++) {
+    uint8_t *top_row = fb->bitmap_data + (position.origin.y + y) * fb->bytes_per_row;
+    uint8_t *bottom_row = fb->bitmap_data + (position.origin.y + position.size.h - y - 2) * fb->bytes_per_row;
+    packed_load(top_row, position.origin.x, position.size.w, top);
+    packed_load(bottom_row, position.origin.x, position.size.w, bottom);
+    packed_store(top_row, position.origin.x, position.size.w, bottom);
+    packed_store(bottom_row, position.origin.x, position.size.w, top);
+  }
+}
+
+// horizontal mirror effect, reversing a byte at a time through reverse_bits.
+// like the 8 bit kernel it reverses the first size.w - 1 pixels of each row
+static void mirror_horizontal_1bit(BitmapInfo *fb, GRect position, void *param) {
+  mirror_span(fb->frame.origin.x, fb->frame.size.w, &position.origin.x, &position.size.w);
+  if (position.size.w < 2 || !packed_fits(position)) return;
+  overdraw_account_rect(position);
+
+  int n = position.size.w - 1;
+  int bytes = (n + 7) / 8;
+  int pad = bytes * 8 - n;
+  uint8_t span[PACKED_SPAN_BYTES], reversed[PACKED_SPAN_BYTES];
+
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++) {
+    uint8_t *row = fb->bitmap_data + y * fb->bytes_per_row;
+    packed_load(row, position.origin.x, n, span);
+    // reversing byte order and bits reverses the span padded to whole bytes,
+    // moving it down by the padding brings its first pixel back to bit 0
+    for (int i = 0; i < bytes; i++) reversed[i] = reverse_bits[span[bytes - 1 - i]];
+    if (pad) {
+      for (int i = 0; i < bytes; i++) reversed[i] = (reversed[i] >> pad) | (i + 1 < bytes ? reversed[i + 1] << (8 - pad) : 0);
+    }
+    packed_store(row, position.origin.x, n, reversed);
+  }
+}
+
+// mask effect, a masked copy of the background bitmap a byte at a time
+static void mask_1bit(BitmapInfo *fb, GRect position, void *param) {
+  EffectMask *mask = (EffectMask *)param;
+  if (!packed_fits(position)) return;
+
+  bool mask_black = gcolor_contains(mask->mask_colors, GColorBlack);
+  bool mask_white = gcolor_contains(mask->mask_colors, GColorWhite);
+  if (!mask_black && !mask_white) return;
+  overdraw_account_rect(position);
+
+  BitmapInfo bg_bitmap_info;
+  bg_bitmap_info.bitmap = mask->bitmap_background;
+  bg_bitmap_info.bitmap_data =  gbitmap_get_data(mask->bitmap_background);
+  bg_bitmap_info.bytes_per_row =  gbitmap_get_bytes_per_row(mask->bitmap_background);
+  bg_bitmap_info.bitmap_format = gbitmap_get_format(mask->bitmap_background);
+
+  int n = position.size.w;
+  uint8_t pixels[PACKED_SPAN_BYTES], background[PACKED_SPAN_BYTES];
+  for (int y = position.origin.y; y < position.origin.y + position.size.h; y++) {
+    uint8_t *row = fb->bitmap_data + y * fb->bytes_per_row;
+    packed_load(row, position.origin.x, n, pixels);
+
+    if (bg_bitmap_info.bitmap_format == GBitmapFormat1Bit) {
+      packed_load(bg_bitmap_info.bitmap_data + y * bg_bitmap_info.bytes_per_row, position.origin.x, n, background);
+    } else { // any other background goes through the generic accessors, converted to black & white
+      memset(background, 0, sizeof(background));
+      for (int x = 0; x < n; x++)
+        if (PalColor(get_pixel(bg_bitmap_info, y, position.origin.x + x), bg_bitmap_info.bitmap_format, GBitmapFormat1Bit))
+          background[x / 8] |= 1 << (x % 8);
+    }
+
+    for (int i = 0; i < (n + 7) / 8; i++) {
+      uint8_t select = (mask_white ? pixels[i] : 0) | (mask_black ? ~pixels[i] : 0);
+      pixels[i] = (pixels[i] & ~select) | (background[i] & select);
+    }
+    packed_store(row, position.origin.x, n, pixels);
+  }
+}
+
+// outline effect. With two colors it only changes anything when both colors are the same,
+// in which case it dilates the pixels of that color by offset_x, offset_y within position
+static void outline_1bit(BitmapInfo *fb, GRect position, void *param) {
+  OutlineRequest *request = (OutlineRequest *)param;
+  EffectOffset *outline = &request->offset;
+  if (!gcolor_equal(outline->orig_color, outline->offset_color)) return;
+  if (!packed_fits(position) || !request->dilated) return;
+
+  uint8_t color = gcolor_equal(outline->orig_color, GColorWhite) ? 0x00 : 0xFF; // xor turning the color into set bits
+  int n = position.size.w;
+  int bytes = (n + 7) / 8;
+  uint8_t *dilated = request->dilated; // horizontally dilated rows
+  overdraw_account_rect(position);
+
+  uint8_t span[PACKED_SPAN_BYTES];
+  for (int y = 0; y < position.size.h; y++) {
+    packed_load(fb->bitmap_data + (position.origin.y + y) * fb->bytes_per_row, position.origin.x, n, span);
+    for (int i = 0; i < bytes; i++) span[i] ^= color;
+    if (n % 8) span[bytes - 1] &= (1 << (n % 8)) - 1;
+
+    uint8_t *out = &dilated[y * bytes];
+    memcpy(out, span, bytes);
+    for (int s = 1; s <= outline->offset_x; s++) {
+      packed_or_shifted(out, span, bytes, s);
+      packed_or_shifted(out, span, bytes, -s);
+    }
+  }
+
+  for (int y = 0; y < position.size.h; y++) {
+    memset(span, 0, bytes);
+    for (int row = MAX(0, y - outline->offset_y); row <= MIN(position.size.h - 1, y + outline->offset_y); row++)
+      for (int i = 0; i < bytes; i++) span[i] |= dilated[row * bytes + i];
+    for (int i = 0; i < bytes; i++) span[i] ^= color;
+    packed_store(fb->bitmap_data + (position.origin.y + y) * fb->bytes_per_row, position.origin.x, n, span);
+  }
+}
+
+#define KERNEL_1BIT(name) name##_1bit
+#else
+#define KERNEL_1BIT(name) NULL
+#endif
+
+typedef void effect_kernel(BitmapInfo *fb, GRect position, void *param);
+
+// instances of one kernel for every format, NULL where not compiled in
+typedef struct {
+  effect_kernel *rect_8bit;
+  effect_kernel *round_8bit;
+  effect_kernel *packed_1bit;
+} EffectKernels;
+
+#define KERNELS(name) ((const EffectKernels){ KERNEL_8BIT(name), KERNEL_ROUND(name), KERNEL_1BIT(name) })
+
+#if defined(PBL_ROUND)
+// trims position to the rows with visible pixels in it and to the columns those rows show
+static void round_clip(GRect *position) {
+  int x0 = position->origin.x, x1 = x0 + position->size.w;
+  int top = position->origin.y, bottom = top + position->size.h;
+  int left = x1, right = x0;
+  int first = bottom, last = top;
+  for (int y = top; y < bottom; y++) {
+    int row_left = MAX(x0, round_rows[y].min_x), row_right = MIN(x1, round_rows[y].max_x + 1);
+    if (row_left >= row_right) continue;
+    first = MIN(first, y);
+    last = y + 1;
+    left = MIN(left, row_left);
+    right = MAX(right, row_right);
+  }
+  *position = first < last ? GRect(left, first, right - left, last - first) : GRectZero;
+}
+#endif
+
+// captures the framebuffer, picks the kernel for its format once and runs it over the
+// part of position that is on screen, so kernels never check pixels against the bounds
+static void run_kernel(GContext *ctx, GRect position, void *param, EffectKernels kernels) {
   GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
+  if (!fb) return;
+
   BitmapInfo bitmap_info;
   bitmap_info.bitmap = fb;
   bitmap_info.bitmap_data =  gbitmap_get_data(fb);
   bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
   bitmap_info.bitmap_format = gbitmap_get_format(fb);
+  bitmap_info.bounds = gbitmap_get_bounds(fb);
+  bitmap_info.frame = position;
+  grect_clip(&position, &bitmap_info.bounds);
+
+  effect_kernel *kernel;
+  switch (bitmap_info.bitmap_format) {
+    case GBitmapFormat8Bit:
+      kernel = kernels.rect_8bit;
+      break;
+#if defined(PBL_ROUND)
+    case GBitmapFormat8BitCircular: {
+      GRect bounds = bitmap_info.bounds;
+      for (int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h && y < (int)ARRAY_LENGTH(round_rows); y++)
+        round_rows[y] = gbitmap_get_data_row_info(fb, y);
+      round_clip(&position);
+      kernel = kernels.round_8bit;
+      break;
+    }
+#endif
+    case GBitmapFormat1Bit:
+      kernel = kernels.packed_1bit;
+      break;
+    default:
+      kernel = NULL;
+      break;
+  }
+  if (kernel && position.size.w > 0 && position.size.h > 0) kernel(&bitmap_info, position, param);
+
+  graphics_release_frame_buffer(ctx, fb);
+}
+
+//  ********* Effect kernels ********* }
+
   
-  for (int y = 0; y < position.size.h; y++)
-     for (int x = 0; x < position.size.w; x++)
-        #ifdef PBL_COLOR // on Basalt simple doing NOT on entire returned byte/pixel
-          set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, (~get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x))|11000000);
-        #else // on Aplite since only 1 and 0 is returning, doing "not" by 1 - pixel
-          set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, 1 - get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x));
-        #endif
- 
-  graphics_release_frame_buffer(ctx, fb);          
-          
+
+// inverter effect.
+void effect_invert(GContext* ctx,  GRect position, void* param) {
+  run_kernel(ctx, position, param, KERNELS(invert));
 }
 
 // colorize effect - given a target color, replace it with a new color
@@ -211,25 +629,7 @@ void effect_invert(GContext* ctx,  GRect position, void* param) {
 // Parameter:  GColor firstColor, GColor secondColor
 void effect_colorize(GContext* ctx,  GRect position, void* param) {
 #ifdef PBL_COLOR // only logical to do anything on Basalt - otherwise you're just ... drawing a black|white GRect
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-  
-  EffectColorpair *paint = (EffectColorpair *)param;
-
-  for (int y = 0; y < position.size.h; y++){
-     for (int x = 0; x < position.size.w; x++){
-        if (gcolor_equal((GColor)get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x), paint->firstColor)){
-           set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, (uint8_t)paint->secondColor.argb);
-        }
-     }
-  graphics_release_frame_buffer(ctx, fb);
-  }
+  run_kernel(ctx, position, param, KERNELS(colorize));
 #endif
 }
 
@@ -239,311 +639,38 @@ void effect_colorize(GContext* ctx,  GRect position, void* param) {
 // Parameter:  GColor firstColor, GColor secondColor
 void effect_colorswap(GContext* ctx,  GRect position, void* param) {
 #ifdef PBL_COLOR // only logical to do anything on Basalt - otherwise you're just ... doing an invert
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
- 
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-  
-  EffectColorpair *swap = (EffectColorpair *)param;
-  GColor pixel;
-
-  for (int y = 0; y < position.size.h; y++){
-     for (int x = 0; x < position.size.w; x++){
-          pixel.argb = get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-          if (gcolor_equal(pixel, swap->firstColor))
-            set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, swap->secondColor.argb);
-          else if (gcolor_equal(pixel, swap->secondColor))
-            set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, swap->firstColor.argb);
-     }
-  graphics_release_frame_buffer(ctx, fb);
-  }
+  run_kernel(ctx, position, param, KERNELS(colorswap));
 #endif
 }
 
 // invert black and white only (leaves all other colors intact).
 void effect_invert_bw_only(GContext* ctx,  GRect position, void* param) {
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-
-#ifdef PBL_COLOR
-  GColor pixel;
-#endif
-  
-  for (int y = 0; y < position.size.h; y++) {
-     for (int x = 0; x < position.size.w; x++) {
-        #ifdef PBL_COLOR // on Basalt invert only black or white
-          pixel.argb = get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-          if (gcolor_equal(pixel, GColorBlack))
-            set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, GColorWhite.argb);
-          else if (gcolor_equal(pixel, GColorWhite))
-            set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, GColorBlack.argb);
-        #else // on Aplite since only 1 and 0 is returning, doing "not" by 1 - pixel
-          set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, 1 - get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x));
-        #endif
-     }
-  }
- 
-  graphics_release_frame_buffer(ctx, fb);          
-          
+  run_kernel(ctx, position, param, KERNELS(invert_bw_only));
 }
 
 // invert brightness of colors (leaves hue more or less intact and does not apply to black and white).
 void effect_invert_brightness(GContext* ctx,  GRect position, void* param) {
 #ifdef PBL_COLOR
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
- 
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-
-  GColor pixel;
-  GColor pixel_new;
-  
-  for (int y = 0; y < position.size.h; y++) {
-     for (int x = 0; x < position.size.w; x++) {
-         pixel.argb = get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-         
-         if (!gcolor_equal(pixel, GColorBlack) && !gcolor_equal(pixel, GColorWhite)) {
-           // Only apply if not black/white (add effect_invert_bw_only for that too)
-           
-           // Color spread is not even, so need to handcraft the opposing brightness of colors,
-           // which is probably subjective and open for improvement
-           if (gcolor_equal(pixel, GColorOxfordBlue))
-             pixel_new = GColorCeleste;
-           else if (gcolor_equal(pixel, GColorDukeBlue))
-             pixel_new = GColorVividCerulean;
-           else if (gcolor_equal(pixel, GColorBlue))
-             pixel_new = GColorPictonBlue;
-           else if (gcolor_equal(pixel, GColorDarkGreen))
-             pixel_new = GColorMintGreen;
-           else if (gcolor_equal(pixel, GColorMidnightGreen))
-             pixel_new = GColorMediumSpringGreen;
-           else if (gcolor_equal(pixel, GColorCobaltBlue))
-             pixel_new = GColorCyan;
-           else if (gcolor_equal(pixel, GColorBlueMoon))
-             pixel_new = GColorElectricBlue;
-           else if (gcolor_equal(pixel, GColorIslamicGreen))
-             pixel_new = GColorMalachite;
-           else if (gcolor_equal(pixel, GColorJaegerGreen))
-             pixel_new = GColorScreaminGreen;
-           else if (gcolor_equal(pixel, GColorTiffanyBlue))
-             pixel_new = GColorCadetBlue;
-           else if (gcolor_equal(pixel, GColorVividCerulean))
-             pixel_new = GColorDukeBlue;
-           else if (gcolor_equal(pixel, GColorGreen))
-             pixel_new = GColorMayGreen;
-           else if (gcolor_equal(pixel, GColorMalachite))
-             pixel_new = GColorIslamicGreen;
-           else if (gcolor_equal(pixel, GColorMediumSpringGreen))
-             pixel_new = GColorMidnightGreen;
-           else if (gcolor_equal(pixel, GColorCyan))
-             pixel_new = GColorCobaltBlue;
-           else if (gcolor_equal(pixel, GColorBulgarianRose))
-             pixel_new = GColorMelon;
-           else if (gcolor_equal(pixel, GColorImperialPurple))
-             pixel_new = GColorRichBrilliantLavender;
-           else if (gcolor_equal(pixel, GColorIndigo))
-             pixel_new = GColorLavenderIndigo;
-           else if (gcolor_equal(pixel, GColorElectricUltramarine))
-             pixel_new = GColorVeryLightBlue;
-           else if (gcolor_equal(pixel, GColorArmyGreen))
-             pixel_new = GColorBrass;
-           else if (gcolor_equal(pixel, GColorDarkGray))
-             pixel_new = GColorLightGray;
-           else if (gcolor_equal(pixel, GColorLiberty))
-             pixel_new = GColorBabyBlueEyes;
-           else if (gcolor_equal(pixel, GColorVeryLightBlue))
-             pixel_new = GColorElectricUltramarine;
-           else if (gcolor_equal(pixel, GColorKellyGreen))
-             pixel_new = GColorGreen;
-           else if (gcolor_equal(pixel, GColorMayGreen))
-             pixel_new = GColorMediumAquamarine;
-           else if (gcolor_equal(pixel, GColorCadetBlue))
-             pixel_new = GColorTiffanyBlue;
-           else if (gcolor_equal(pixel, GColorPictonBlue))
-             pixel_new = GColorBlue;
-           else if (gcolor_equal(pixel, GColorBrightGreen))
-             pixel_new = GColorIslamicGreen;
-           else if (gcolor_equal(pixel, GColorScreaminGreen))
-             pixel_new = GColorKellyGreen;
-           else if (gcolor_equal(pixel, GColorMediumAquamarine))
-             pixel_new = GColorMayGreen;
-           else if (gcolor_equal(pixel, GColorElectricBlue))
-             pixel_new = GColorBlueMoon;
-           else if (gcolor_equal(pixel, GColorDarkCandyAppleRed))
-             pixel_new = GColorMelon;
-           else if (gcolor_equal(pixel, GColorJazzberryJam))
-             pixel_new = GColorBrilliantRose;
-           else if (gcolor_equal(pixel, GColorPurple))
-             pixel_new = GColorShockingPink;
-           else if (gcolor_equal(pixel, GColorVividViolet))
-             pixel_new = GColorPurpureus;
-           else if (gcolor_equal(pixel, GColorWindsorTan))
-             pixel_new = GColorRoseVale;
-           else if (gcolor_equal(pixel, GColorRoseVale))
-             pixel_new = GColorWindsorTan;
-           else if (gcolor_equal(pixel, GColorPurpureus))
-             pixel_new = GColorVividViolet;
-           else if (gcolor_equal(pixel, GColorLavenderIndigo))
-             pixel_new = GColorIndigo;
-           else if (gcolor_equal(pixel, GColorLimerick))
-             pixel_new = GColorPastelYellow;
-           else if (gcolor_equal(pixel, GColorBrass))
-             pixel_new = GColorArmyGreen;
-           else if (gcolor_equal(pixel, GColorLightGray))
-             pixel_new = GColorDarkGray;
-           else if (gcolor_equal(pixel, GColorBabyBlueEyes))
-             pixel_new = GColorLiberty;
-           else if (gcolor_equal(pixel, GColorSpringBud))
-             pixel_new = GColorDarkGreen;
-           else if (gcolor_equal(pixel, GColorInchworm))
-             pixel_new = GColorMidnightGreen;
-           else if (gcolor_equal(pixel, GColorMintGreen))
-             pixel_new = GColorDarkGreen;
-           else if (gcolor_equal(pixel, GColorCeleste))
-             pixel_new = GColorOxfordBlue;
-           else if (gcolor_equal(pixel, GColorRed))
-             pixel_new = GColorSunsetOrange;
-           else if (gcolor_equal(pixel, GColorFolly))
-             pixel_new = GColorMelon;
-           else if (gcolor_equal(pixel, GColorFashionMagenta))
-             pixel_new = GColorMagenta ;
-           else if (gcolor_equal(pixel, GColorMagenta))
-             pixel_new = GColorFashionMagenta;
-           else if (gcolor_equal(pixel, GColorOrange))
-             pixel_new = GColorRajah;
-           else if (gcolor_equal(pixel, GColorSunsetOrange))
-             pixel_new = GColorRed;
-           else if (gcolor_equal(pixel, GColorBrilliantRose))
-             pixel_new = GColorJazzberryJam;
-           else if (gcolor_equal(pixel, GColorShockingPink))
-             pixel_new = GColorPurple;
-           else if (gcolor_equal(pixel, GColorChromeYellow))
-             pixel_new = GColorWindsorTan;
-           else if (gcolor_equal(pixel, GColorRajah))
-             pixel_new = GColorOrange;
-           else if (gcolor_equal(pixel, GColorMelon))
-             pixel_new = GColorDarkCandyAppleRed;
-           else if (gcolor_equal(pixel, GColorRichBrilliantLavender))
-             pixel_new = GColorImperialPurple;
-           else if (gcolor_equal(pixel, GColorYellow))
-             pixel_new = GColorChromeYellow;
-           else if (gcolor_equal(pixel, GColorIcterine))
-             pixel_new = GColorChromeYellow;
-           else if (gcolor_equal(pixel, GColorPastelYellow))
-             pixel_new = GColorChromeYellow;
-           
-           set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, pixel_new.argb);
-         }
-     }
-  }
- 
-  graphics_release_frame_buffer(ctx, fb);          
-          
+  run_kernel(ctx, position, param, KERNELS(invert_brightness));
 #endif
 }
 
 // vertical mirror effect.
 void effect_mirror_vertical(GContext* ctx, GRect position, void* param) {
-  uint8_t temp_pixel;  
-  
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-
-  for (int y = 0; y < position.size.h / 2 ; y++)
-     for (int x = 0; x < position.size.w; x++){
-        temp_pixel = get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-        set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, get_pixel(bitmap_info, position.origin.y + position.size.h - y - 2, x + position.origin.x));
-        set_pixel(bitmap_info, position.origin.y + position.size.h - y - 2, x + position.origin.x, temp_pixel);
-     }
-  
-  graphics_release_frame_buffer(ctx, fb);
+  run_kernel(ctx, position, param, KERNELS(mirror_vertical));
 }
 
 
 // horizontal mirror effect.
 void effect_mirror_horizontal(GContext* ctx, GRect position, void* param) {
-  uint8_t temp_pixel;  
-  
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-
-  for (int y = 0; y < position.size.h; y++)
-     for (int x = 0; x < position.size.w / 2; x++){
-        temp_pixel = get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-        set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, get_pixel(bitmap_info, y + position.origin.y, position.origin.x + position.size.w - x - 2));
-        set_pixel(bitmap_info, y + position.origin.y, position.origin.x + position.size.w - x - 2, temp_pixel);
-     }
-  
-  graphics_release_frame_buffer(ctx, fb);
+  run_kernel(ctx, position, param, KERNELS(mirror_horizontal));
 }
 
 // Rotate 90 degrees
 // Added by Ron64
 // Parameter:  true: rotate right/clockwise,  false: rotate left/counter_clockwise
 void effect_rotate_90_degrees(GContext* ctx,  GRect position, void* param){
-
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-  
-  bool right = (bool)param;
-  uint8_t qtr, xCn, yCn, temp_pixel;
-  xCn= position.origin.x + position.size.w /2;
-  yCn= position.origin.y + position.size.h /2;
-  qtr=position.size.w;
-  if (position.size.h < qtr)
-    qtr= position.size.h;
-  qtr= qtr/2;
-
-  for (int c1 = 0; c1 < qtr; c1++)
-    for (int c2 = 1; c2 < qtr; c2++){
-      temp_pixel = get_pixel(bitmap_info, yCn +c1, xCn +c2);
-      if (right){
-        set_pixel(bitmap_info, yCn +c1, xCn +c2, get_pixel(bitmap_info, yCn -c2, xCn +c1));
-        set_pixel(bitmap_info, yCn -c2, xCn +c1, get_pixel(bitmap_info, yCn -c1, xCn -c2));
-        set_pixel(bitmap_info, yCn -c1, xCn -c2, get_pixel(bitmap_info, yCn +c2, xCn -c1));
-        set_pixel(bitmap_info, yCn +c2, xCn -c1, temp_pixel);
-      }
-      else{
-        set_pixel(bitmap_info, yCn +c1, xCn +c2, get_pixel(bitmap_info, yCn +c2, xCn -c1));
-        set_pixel(bitmap_info, yCn +c2, xCn -c1, get_pixel(bitmap_info, yCn -c1, xCn -c2));
-        set_pixel(bitmap_info, yCn -c1, xCn -c2, get_pixel(bitmap_info, yCn -c2, xCn +c1));
-        set_pixel(bitmap_info, yCn -c2, xCn +c1, temp_pixel);
-      }
-     }
-  
-  graphics_release_frame_buffer(ctx, fb);
+  run_kernel(ctx, position, param, KERNELS(rotate_90_degrees));
 }
 
 // Zoom effect.
@@ -551,35 +678,7 @@ void effect_rotate_90_degrees(GContext* ctx,  GRect position, void* param){
 // Parameter: Y zoom (high byte) X zoom(low byte),  0x10 no zoom 0x20 200% 0x08 50%, 
 // use the percentage macro EL_ZOOM(150,60). In this example: Y- zoom in 150%, X- zoom out to 60% 
 void effect_zoom(GContext* ctx,  GRect position, void* param){
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-
-  uint8_t xCn, yCn, Y1,X1, ratioY, ratioX;
-  xCn= position.origin.x + position.size.w /2;
-  yCn= position.origin.y + position.size.h /2;
-
-  ratioY= (int32_t)param >>8 & 0xFF;
-  ratioX= (int32_t)param & 0xFF;
-
-  for (int y = 0; y <= position.size.h>>1; y++)
-    for (int x = 0; x <= position.size.w>>1; x++)
-    {
-      //yS,xS scan source: centre to out or out to centre
-      int8_t yS = (ratioY>16) ? (position.size.h/2)- y: y; 
-      int8_t xS = (ratioX>16) ? (position.size.w/2)- x: x;
-      Y1= (yS<<4) /ratioY;
-      X1= (xS<<4) /ratioX;
-      set_pixel(bitmap_info, yCn +yS, xCn +xS, get_pixel(bitmap_info, yCn +Y1, xCn +X1)); 
-      set_pixel(bitmap_info, yCn +yS, xCn -xS, get_pixel(bitmap_info, yCn +Y1, xCn -X1));
-      set_pixel(bitmap_info, yCn -yS, xCn +xS, get_pixel(bitmap_info, yCn -Y1, xCn +X1));
-      set_pixel(bitmap_info, yCn -yS, xCn -xS, get_pixel(bitmap_info, yCn -Y1, xCn -X1));
-    }
-  graphics_release_frame_buffer(ctx, fb);
+  run_kernel(ctx, position, param, KERNELS(zoom));
 //Todo: Should probably reduce Y size on zoom out or limit reading beyond edge of screen.
 }
 
@@ -587,44 +686,18 @@ void effect_zoom(GContext* ctx,  GRect position, void* param){
 // Added by Ron64
 // Parameters: lens focal(high byte) and object distance(low byte)
 void effect_lens(GContext* ctx,  GRect position, void* param){
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-  
-  uint8_t d,r, xCn, yCn;
-
-  xCn= position.origin.x + position.size.w /2;
-  yCn= position.origin.y + position.size.h /2;
-  d=position.size.w;
-  if (position.size.h < d)
-    d= position.size.h;
-  r= d/2; // radius of lens
-  float focal =   (int32_t)param >>8 & 0xFF;// focal point of lens
-  float obj_dis = (int32_t)param & 0xFF;//distance of object from focal point.
-  
-  for (int y = r; y >= 0; --y)
-    for (int x = r; x >= 0; --x)
-      if (x*x+y*y < r*r)
-      {
-        int Y1= my_tan(my_asin(y/focal))*obj_dis;
-        int X1= my_tan(my_asin(x/focal))*obj_dis;
-        set_pixel(bitmap_info, yCn +y, xCn +x, get_pixel(bitmap_info, yCn +Y1, xCn +X1)); 
-        set_pixel(bitmap_info, yCn +y, xCn -x, get_pixel(bitmap_info, yCn +Y1, xCn -X1));
-        set_pixel(bitmap_info, yCn -y, xCn +x, get_pixel(bitmap_info, yCn -Y1, xCn +X1));
-        set_pixel(bitmap_info, yCn -y, xCn -x, get_pixel(bitmap_info, yCn -Y1, xCn -X1));
-      }
-    graphics_release_frame_buffer(ctx, fb);
-//Todo: Change to lock-up arcsin table in the future. (Currently using floating point math library that is relatively big & slow)
+  // the trigonometry runs once per row and column, effect_type_lens keeps the offsets between frames
+  int radius = lens_radius(position);
+  int16_t offsets[radius + 1];
+  lens_offsets(offsets, radius, (int32_t)param >> 8 & 0xFF, (int32_t)param & 0xFF);
+  // every tier down computes the lens for one pixel out of a bigger block
+  LensRequest lens = { .offsets = offsets, .step = 1 + effect_get_quality() };
+  run_kernel(ctx, position, &lens, KERNELS(lens));
 }
   
 // mask effect.
 // see struct EffectMask for parameter description  
 void effect_mask(GContext* ctx, GRect position, void* param) {
-  GColor temp_pixel;  
   EffectMask *mask = (EffectMask *)param;
 
   //drawing background - only if real color is passed
@@ -641,34 +714,8 @@ void effect_mask(GContext* ctx, GRect position, void* param) {
      graphics_draw_bitmap_in_rect(ctx, mask->bitmap_mask, GRect(0, 0, position.size.w, position.size.h));
   }
     
-  //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
-  
-  //capturing background bitmap
-  BitmapInfo bg_bitmap_info;
-  bg_bitmap_info.bitmap = mask->bitmap_background;
-  bg_bitmap_info.bitmap_data =  gbitmap_get_data(mask->bitmap_background);
-  bg_bitmap_info.bytes_per_row =  gbitmap_get_bytes_per_row(mask->bitmap_background);
-  bg_bitmap_info.bitmap_format = gbitmap_get_format(mask->bitmap_background);
-  
   //looping throughout layer replacing mask with bg bitmap
-  for (int y = 0; y < position.size.h; y++)
-     for (int x = 0; x < position.size.w; x++) {
-      temp_pixel = (GColor)get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-       if ( gcolor_contains(mask->mask_colors, temp_pixel)) { // if array of mask colors matches current screen pixel color:
-         // getting pixel from background bitmap (adjusted to pallette by PalColor function because palette of bg bitmap and framebuffer may differ)
-         set_pixel(bitmap_info, y + position.origin.y, x + position.origin.x, PalColor(get_pixel(bg_bitmap_info, y + position.origin.y, x + position.origin.x), bg_bitmap_info.bitmap_format, bitmap_info.bitmap_format));
-       } 
-  }
-  
-  graphics_release_frame_buffer(ctx, fb);
-  
+  run_kernel(ctx, position, param, KERNELS(mask));
 }
 
 void effect_fps(GContext* ctx, GRect position, void* param) {
@@ -697,115 +744,95 @@ void effect_fps(GContext* ctx, GRect position, void* param) {
 // shadow effect.
 // see struct EffecOffset for parameter description  
 void effect_shadow(GContext* ctx, GRect position, void* param) {
-  GColor temp_pixel;  
-  int shadow_x, shadow_y;
-  EffectOffset *shadow = (EffectOffset *)param;
-  
-  #ifndef PBL_COLOR
-    uint8_t draw_color = gcolor_equal(shadow->offset_color, GColorWhite)? 1 : 0;
-    uint8_t skip_color = gcolor_equal(shadow->orig_color, GColorWhite)? 1 : 0;
-  #endif
-  
-   //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
+  EffectOffset shadow = *(EffectOffset *)param;
+  if (effect_get_quality() != EFFECT_QUALITY_FULL && shadow.option == 1) {
+    shadow.option = 0; // a line per pixel is the expensive part of a long shadow
+  }
+  run_kernel(ctx, position, &shadow, KERNELS(shadow));
+}
 
-  
-  //looping throughout making shadow
-  for (int y = 0; y < position.size.h; y++)
-     for (int x = 0; x < position.size.w; x++) {
-       temp_pixel = (GColor)get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-       
-       if (gcolor_equal(temp_pixel, shadow->orig_color)) {
-         shadow_x =  x + position.origin.x + shadow->offset_x;
-         shadow_y =  y + position.origin.y + shadow->offset_y;
-         
-         if (shadow->option == 1) {
-            #ifdef PBL_COLOR // for Basalt simple calling line-drawing routine
-               set_line(bitmap_info, y + position.origin.y, x + position.origin.x, shadow_y, shadow_x, shadow->offset_color.argb, shadow->orig_color.argb, NULL);
-            #else // for Aplite - passing user-defined array to determine if pixels have been set or not
-               set_line(bitmap_info, y + position.origin.y, x + position.origin.x, shadow_y, shadow_x, draw_color, skip_color, shadow->aplite_visited); 
-            #endif
-           
-         } else {
-           
-             if (shadow_x >= 0 && shadow_x <=143 && shadow_y >= 0 && shadow_y <= 167) {
-             
-               temp_pixel = (GColor)get_pixel(bitmap_info, shadow_y, shadow_x);
-               if (!gcolor_equal(temp_pixel, shadow->orig_color) & !gcolor_equal(temp_pixel, shadow->offset_color) ) {
-                 #ifdef PBL_COLOR
-                    set_pixel(bitmap_info,  shadow_y, shadow_x, shadow->offset_color.argb);  
-                 #else
-                    set_pixel(bitmap_info,  shadow_y, shadow_x, gcolor_equal(shadow->offset_color, GColorWhite)? 1 : 0);
-                 #endif
-               }
-             }
-           
-         }
-         
-         
-       }
+// the reduced tiers draw a thin outline
+static void outline_run(GContext *ctx, GRect position, const EffectOffset *offset, uint8_t *dilated) {
+  OutlineRequest outline = { .offset = *offset, .dilated = dilated };
+  if (effect_get_quality() != EFFECT_QUALITY_FULL) {
+    outline.offset.offset_x = MIN(outline.offset.offset_x, 1);
+    outline.offset.offset_y = MIN(outline.offset.offset_y, 1);
   }
-         
-  graphics_release_frame_buffer(ctx, fb);
- 
+  run_kernel(ctx, position, &outline, KERNELS(outline));
 }
 
+// effect_type_outline keeps the scratch rows between frames, this allocates them every call
 void effect_outline(GContext* ctx, GRect position, void* param) {
-  GColor temp_pixel;  
-  int outlinex[8];
-  int outliney[8];
-  EffectOffset *outline = (EffectOffset *)param;
-  
-   //capturing framebuffer bitmap
-  GBitmap *fb = graphics_capture_frame_buffer(ctx);
-  
-  BitmapInfo bitmap_info;
-  bitmap_info.bitmap = fb;
-  bitmap_info.bitmap_data =  gbitmap_get_data(fb);
-  bitmap_info.bytes_per_row = gbitmap_get_bytes_per_row(fb);
-  bitmap_info.bitmap_format = gbitmap_get_format(fb);
+  size_t size = outline_scratch_size(position);
+  uint8_t *dilated = size ? malloc(size) : NULL;
+  if (size && !dilated) return;
+  outline_run(ctx, position, (EffectOffset *)param, dilated);
+  free(dilated);
+}
 
-  
-  //loop through pixels from framebuffer
-  for (int y = 0; y < position.size.h; y++)
-    for (int x = 0; x < position.size.w; x++) {
-      for (int a = 0; a <= outline->offset_x; a++) 
-        for (int b = 0; b <= outline->offset_y; b++) {
-  
-          temp_pixel = (GColor)get_pixel(bitmap_info, y + position.origin.y, x + position.origin.x);
-       
-          if (gcolor_equal(temp_pixel, outline->orig_color)) {
-            outlinex[0] = x + position.origin.x - a;
-            outliney[0] = y + position.origin.y - b;
-            outlinex[1] = x + position.origin.x + a;
-            outliney[1] = y + position.origin.y + b;
-            outlinex[2] = x + position.origin.x - a;
-            outliney[2] = y + position.origin.y + b;
-            outlinex[3] = x + position.origin.x + a;
-            outliney[3] = y + position.origin.y - b;
-         
-            for (int i = 0; i < 4; i++) {
-              // TODO: centralize the constants
-              if (outlinex[i] >= 0 && outlinex[i] <=144 && outliney[i] >= 0 && outliney[i] <= 168) {
-                temp_pixel = (GColor)get_pixel(bitmap_info, outliney[i], outlinex[i]);
-                if (!gcolor_equal(temp_pixel, outline->orig_color)) {
-                  #ifdef PBL_COLOR
-                    set_pixel(bitmap_info, outliney[i], outlinex[i], outline->offset_color.argb);  
-                  #else
-                    set_pixel(bitmap_info, outliney[i], outlinex[i], gcolor_equal(outline->offset_color, GColorWhite)? 1 : 0);
-                  #endif
-                }
-              }
-            }
-          }
-        }
-    }
+//  ********* Effect descriptors *********
 
-  graphics_release_frame_buffer(ctx, fb);
+static void zoom_apply(Effect *effect, GContext *ctx, GRect frame) {
+  // packed the way the zoom kernels read EL_ZOOM
+  EffectZoomParams *zoom = &effect->params.zoom;
+  run_kernel(ctx, frame, (void*)(int32_t)(zoom->y << 8 | zoom->x), KERNELS(zoom));
+}
+
+const EffectType effect_type_zoom = {
+  .apply = zoom_apply,
+};
+
+static bool lens_prepare(Effect *effect, GRect frame) {
+  int radius = lens_radius(frame);
+  int16_t *offsets = malloc((radius + 1) * sizeof(int16_t));
+  if (!offsets) return false;
+  lens_offsets(offsets, radius, effect->params.lens.focal, effect->params.lens.object_distance);
+  effect->cache = offsets;
+  return true;
+}
+
+static void lens_apply(Effect *effect, GContext *ctx, GRect frame) {
+  LensRequest lens = { .offsets = effect->cache, .step = 1 + effect_get_quality() };
+  run_kernel(ctx, frame, &lens, KERNELS(lens));
+}
+
+static void lens_destroy(Effect *effect) {
+  free(effect->cache);
+  effect->cache = NULL;
+}
+
+const EffectType effect_type_lens = {
+  .prepare = lens_prepare,
+  .apply = lens_apply,
+  .destroy = lens_destroy,
+};
+
+static bool outline_prepare(Effect *effect, GRect frame) {
+  size_t size = outline_scratch_size(frame);
+  if (!size) return true;
+  effect->cache = malloc(size);
+  return effect->cache != NULL;
 }
+
+static void outline_apply(Effect *effect, GContext *ctx, GRect frame) {
+  outline_run(ctx, frame, &effect->params.outline, effect->cache);
+}
+
+static void outline_destroy(Effect *effect) {
+  free(effect->cache);
+  effect->cache = NULL;
+}
+
+const EffectType effect_type_outline = {
+  .prepare = outline_prepare,
+  .apply = outline_apply,
+  .destroy = outline_destroy,
+};
+
+static void callback_apply(Effect *effect, GContext *ctx, GRect frame) {
+  effect->params.callback.callback(ctx, frame, effect->params.callback.param);
+}
+
+const EffectType effect_type_callback = {
+  .apply = callback_apply,
+};
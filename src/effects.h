@@ -7,6 +7,8 @@ typedef struct {
    uint8_t *bitmap_data;
    int bytes_per_row;
    GBitmapFormat bitmap_format;
+   GRect bounds;  // bitmap bounds, kernels never touch pixels outside them
+   GRect frame;   // the effect's rect before clipping, geometric kernels take their centre from it
 }  BitmapInfo;
   
 // structure of mask for masking effects
@@ -46,6 +48,18 @@ typedef struct {
 
 typedef void effect_cb(GContext* ctx, GRect position, void* param);
 
+// quality tiers effects step down through when their layer runs over its frame budget
+typedef enum {
+  EFFECT_QUALITY_FULL,
+  EFFECT_QUALITY_REDUCED,  // cheaper variants: halved blur radius, thin outline, short shadow, coarser lens
+  EFFECT_QUALITY_MINIMAL,  // cheapest variants, decorative effects are skipped
+  EFFECT_QUALITY_COUNT
+} EffectQuality;
+
+//quality the effect being run should render at, set by the effect layer around its chain
+EffectQuality effect_get_quality(void);
+void effect_set_quality(EffectQuality quality);
+
 // inverter effect.
 // Added by Yuriy Galanter
 effect_cb effect_invert;
@@ -114,3 +128,81 @@ effect_cb effect_fps;
 effect_cb effect_shadow;
 
 effect_cb effect_outline;
+
+
+// ********* Effect descriptors *********
+// An effect with typed parameters and state of its own, run by an EffectLayer
+// through the hooks of its EffectType. prepare builds what the effect can
+// compute ahead of time for its parameters and frame size (tables, scratch
+// buffers) into its cache; it runs again only once the parameters change,
+// on_resize when the frame size does, and destroy frees the cache when the
+// effect leaves its layer.
+
+typedef struct Effect Effect;
+
+// zoom per axis in 16ths, 16 is no zoom; EFFECT_ZOOM_PERCENT(150) zooms in 150%
+typedef struct {
+  uint8_t x;
+  uint8_t y;
+} EffectZoomParams;
+
+#define EFFECT_ZOOM_PERCENT(p) ((p)*16/100)
+
+typedef struct {
+  uint8_t focal;            // focal point of the lens
+  uint8_t object_distance;  // distance of the object from the focal point
+} EffectLensParams;
+
+typedef struct {
+  uint8_t radius;
+} EffectBlurParams;
+
+// a plain effect_cb and its pointer parameter
+typedef struct {
+  effect_cb *callback;
+  void      *param;
+} EffectCallbackParams;
+
+typedef union {
+  EffectZoomParams     zoom;
+  EffectLensParams     lens;
+  EffectBlurParams     blur;
+  EffectOffset         outline;
+  EffectCallbackParams callback;
+} EffectParams;
+
+typedef struct {
+  //optional: builds the cache for the params and frame; false skips the effect this frame
+  bool (*prepare)(Effect *effect, GRect frame);
+  //draws the effect over frame
+  void (*apply)(Effect *effect, GContext *ctx, GRect frame);
+  //optional: adapts the cache to a new frame size; without it the cache is destroyed and prepared again
+  void (*on_resize)(Effect *effect, GRect frame);
+  //optional: frees the cache
+  void (*destroy)(Effect *effect);
+} EffectType;
+
+struct Effect {
+  const EffectType *type;
+  EffectParams params;
+  void    *cache;          // owned by the type's hooks
+  GSize   prepared_size;   // frame size the cache was built for
+  bool    prepared;
+  bool    decorative;      // skipped at EFFECT_QUALITY_MINIMAL
+  Effect  *next;           // next in its layer's chain, or in the free pool
+};
+
+// zoom with EffectZoomParams
+extern const EffectType effect_type_zoom;
+
+// lens with EffectLensParams, the displacement of every row and column is computed once in prepare
+extern const EffectType effect_type_lens;
+
+// blur with EffectBlurParams, the scratch rows are allocated once in prepare
+extern const EffectType effect_type_blur;
+
+// outline with an EffectOffset, the 1 bit scratch rows are allocated once in prepare
+extern const EffectType effect_type_outline;
+
+// runs an EffectCallbackParams, what effect_layer_add_effect adds
+extern const EffectType effect_type_callback;
@@ -0,0 +1,215 @@
+#include <pebble.h>
+#include "energy.h"
+
+#ifdef ENERGY
+
+// rough cost of each unit in milli-nAh, a starting point the observed drain corrects:
+// a frame is ~10 ms of CPU at ~10 mA, the motor draws ~60 mA, a wakeup is ~1 ms
+// of CPU, a message ~20 ms of radio, an effect or span pixel a few cycles
+static const uint32_t ENERGY_COSTS[ENERGY_EVENT_COUNT] = {
+  [ENERGY_REDRAW]        = 28000,
+  [ENERGY_EFFECT_PIXELS] = 1,
+  [ENERGY_VIBE_MS]       = 16700,
+  [ENERGY_TIMER_WAKEUP]  = 3000,
+  [ENERGY_TICK]          = 3000,
+  [ENERGY_MESSAGE]       = 56000,
+  [ENERGY_SPAN_PIXELS]   = 1,
+};
+
+static const char *ENERGY_NAMES[ENERGY_EVENT_COUNT] = {
+  [ENERGY_REDRAW]        = "redraws",
+  [ENERGY_EFFECT_PIXELS] = "effects",
+  [ENERGY_VIBE_MS]       = "vibration",
+  [ENERGY_TIMER_WAKEUP]  = "timers",
+  [ENERGY_TICK]          = "ticks",
+  [ENERGY_MESSAGE]       = "messages",
+  [ENERGY_SPAN_PIXELS]   = "glyphs and hands",
+};
+
+static EnergyHour current;
+static uint8_t charge_percent;
+
+static uint32_t hour_now(void) {
+  return time(NULL) / 3600;
+}
+
+static uint32_t hour_key(uint32_t hour) {
+  return PERSIST_KEY_ENERGY_HOURS + hour % ENERGY_HISTORY_HOURS;
+}
+
+static void start_hour(uint32_t hour) {
+  memset(&current, 0, sizeof(current));
+  current.hour = hour;
+  current.charge_start = current.charge_end = charge_percent;
+}
+
+static void persist_hour(void) {
+  current.charge_end = charge_percent;
+  persist_write_data(hour_key(current.hour), &current, sizeof(current));
+}
+
+// reads back an hour of the last day; false if its slot is empty, stale or from another layout
+static bool load_hour(uint32_t hour, EnergyHour *out) {
+  uint32_t key = hour_key(hour);
+  return persist_exists(key) && persist_get_size(key) == sizeof(EnergyHour) &&
+         persist_read_data(key, out, sizeof(EnergyHour)) == sizeof(EnergyHour) && out->hour == hour;
+}
+
+// milli-nAh in a uAh and in a nAh
+#define ENERGY_UNITS_PER_UAH 1000000
+#define ENERGY_UNITS_PER_NAH 1000
+
+// mAh/day as "m.mmm" from milli-nAh over a number of hours
+static void format_mah_per_day(char *buffer, size_t size, uint64_t cost, int hours) {
+  uint32_t uah_per_day = hours ? cost * 24 / hours / ENERGY_UNITS_PER_UAH : 0;
+  snprintf(buffer, size, "%d.%03d", (int)(uah_per_day / 1000), (int)(uah_per_day % 1000));
+}
+
+// what the watch draws per hour with the face doing nothing (OS, Bluetooth, display),
+// assumed when the history is too even to fit it: about a week on a full battery
+#define ENERGY_IDLE_NAH_PER_HOUR 700000
+
+// hours on battery before the baseline is fitted rather than assumed
+#define ENERGY_FIT_MIN_HOURS 6
+
+// splits the drain of the observed hours into a baseline and a scale of the modeled cost:
+// drain = baseline + modeled * scale_percent / 100, least squares over the hours when their
+// modeled costs vary enough to tell the two apart, otherwise with the idle baseline assumed
+static void energy_fit(const int64_t *modeled, const int64_t *drain, int count,
+                       int64_t *baseline, uint32_t *scale_percent, bool *fitted) {
+  int64_t modeled_sum = 0, drain_sum = 0;
+  for (int i = 0; i < count; i++) {
+    modeled_sum += modeled[i];
+    drain_sum += drain[i];
+  }
+  *fitted = false;
+  *baseline = 0;
+  *scale_percent = 100;
+  if (count == 0) {
+    return;
+  }
+
+  // sums of squares and products around the means, scaled by count to stay in integers
+  int64_t variance = 0, covariance = 0;
+  for (int i = 0; i < count; i++) {
+    int64_t dm = modeled[i] * count - modeled_sum;
+    variance += dm * dm / count;
+    covariance += dm * (drain[i] * count - drain_sum) / count;
+  }
+  if (count >= ENERGY_FIT_MIN_HOURS && variance > 0 && covariance > 0) {
+    int64_t scale = covariance * 100 / variance;
+    int64_t fit_baseline = (drain_sum * 100 - scale * modeled_sum) / 100 / count;
+    if (fit_baseline >= 0) {
+      *fitted = true;
+      *baseline = fit_baseline;
+      *scale_percent = scale;
+      return;
+    }
+  }
+
+  *baseline = MIN(ENERGY_IDLE_NAH_PER_HOUR, drain_sum / count);
+  int64_t feature_drain = drain_sum - *baseline * count;
+  *scale_percent = modeled_sum ? feature_drain * 100 / modeled_sum : 100;
+}
+
+// prices the history per feature, splits the drain the battery reported into a
+// baseline and the features, and scales the features to their share of it
+static void energy_report(void) {
+  // all in milli-nAh, so hours of a few frames don't round to nothing
+  uint64_t feature_cost[ENERGY_EVENT_COUNT] = { 0 };
+  uint64_t modeled = 0, observed = 0;
+  int hours = 0, observed_hours = 0;
+  // per hour on battery in nAh, for the fit
+  int64_t hour_modeled[ENERGY_HISTORY_HOURS], hour_drain[ENERGY_HISTORY_HOURS];
+
+  for (uint32_t hour = current.hour - ENERGY_HISTORY_HOURS; hour != current.hour; hour++) {
+    EnergyHour record;
+    if (!load_hour(hour, &record)) {
+      continue;
+    }
+    ++hours;
+    uint64_t hour_cost = 0;
+    for (int i = 0; i < ENERGY_EVENT_COUNT; i++) {
+      uint64_t cost = (uint64_t)record.counts[i] * ENERGY_COSTS[i];
+      feature_cost[i] += cost;
+      hour_cost += cost;
+    }
+    modeled += hour_cost;
+    // only hours on battery say anything about the drain
+    if (!record.charged && record.charge_start >= record.charge_end) {
+      uint64_t drain = (uint64_t)(record.charge_start - record.charge_end) * ENERGY_BATTERY_MAH * 10 * ENERGY_UNITS_PER_UAH;
+      observed += drain;
+      hour_modeled[observed_hours] = hour_cost / ENERGY_UNITS_PER_NAH;
+      hour_drain[observed_hours] = drain / ENERGY_UNITS_PER_NAH;
+      ++observed_hours;
+    }
+  }
+  if (hours == 0) {
+    return;
+  }
+
+  // the battery reports 10% steps, so the fit only means something over many hours
+  int64_t baseline_nah;
+  uint32_t scale_percent;
+  bool fitted;
+  energy_fit(hour_modeled, hour_drain, observed_hours, &baseline_nah, &scale_percent, &fitted);
+
+  char modeled_text[16], observed_text[16], baseline_text[16], feature_text[16];
+  format_mah_per_day(modeled_text, sizeof(modeled_text), modeled, hours);
+  format_mah_per_day(observed_text, sizeof(observed_text), observed, observed_hours);
+  format_mah_per_day(baseline_text, sizeof(baseline_text), (uint64_t)baseline_nah * ENERGY_UNITS_PER_NAH, 1);
+  APP_LOG(APP_LOG_LEVEL_INFO, "energy over %dh: modeled %s mAh/day, observed %s mAh/day over %dh on battery",
+    hours, modeled_text, observed_text, observed_hours);
+  APP_LOG(APP_LOG_LEVEL_INFO, "energy baseline: %s mAh/day (%s), features scaled %d%%",
+    baseline_text, fitted ? "fitted" : "assumed idle", (int)scale_percent);
+  for (int i = 0; i < ENERGY_EVENT_COUNT; i++) {
+    format_mah_per_day(feature_text, sizeof(feature_text), feature_cost[i] * scale_percent / 100, hours);
+    APP_LOG(APP_LOG_LEVEL_INFO, "energy %s: %s mAh/day", ENERGY_NAMES[i], feature_text);
+  }
+}
+
+// what the hour that just ended did
+static void log_hour(const EnergyHour *hour) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "energy hour: %d redraws, %d effect px, %d span px, %d ms vibe, %d timers, %d ticks, %d messages, battery %d%%->%d%%%s",
+    (int)hour->counts[ENERGY_REDRAW], (int)hour->counts[ENERGY_EFFECT_PIXELS], (int)hour->counts[ENERGY_SPAN_PIXELS],
+    (int)hour->counts[ENERGY_VIBE_MS], (int)hour->counts[ENERGY_TIMER_WAKEUP], (int)hour->counts[ENERGY_TICK],
+    (int)hour->counts[ENERGY_MESSAGE],
+    hour->charge_start, hour->charge_end, hour->charged ? " charging" : "");
+}
+
+void energy_count(EnergyEvent event, uint32_t amount) {
+  current.counts[event] += amount;
+}
+
+void energy_tick(struct tm *tick_time) {
+  uint32_t hour = hour_now();
+  if (hour != current.hour) {
+    persist_hour();
+    log_hour(&current);
+    start_hour(hour);
+    energy_report();
+  }
+  energy_count(ENERGY_TICK, 1);
+}
+
+void energy_battery(BatteryChargeState charge) {
+  charge_percent = charge.charge_percent;
+  current.charge_end = charge_percent;
+  if (charge.is_charging || charge.is_plugged) {
+    current.charged = true;
+  }
+}
+
+void energy_init(void) {
+  charge_percent = battery_state_service_peek().charge_percent;
+  uint32_t hour = hour_now();
+  if (!load_hour(hour, &current)) {
+    start_hour(hour);
+  }
+}
+
+void energy_deinit(void) {
+  persist_hour();
+}
+
+#endif
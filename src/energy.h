@@ -0,0 +1,72 @@
+#pragma once
+#include <pebble.h>
+
+// Energy accounting, only compiled into builds configured with --energy.
+// Counts what the face makes the watch do (redraws, effect pixels, glyph and
+// hand pixels, vibration, timer and tick wakeups, AppMessages) per hour, next to the battery charge
+// at the start and end of the hour. The last ENERGY_HISTORY_HOURS hours are
+// persisted, one key per hour, and every hour the log gets an estimate of the
+// mAh/day each feature costs: the counts priced with ENERGY_COSTS, scaled so
+// that with a baseline for everything the face doesn't do (OS, Bluetooth,
+// display) they add up to the drain the battery actually reported. The
+// baseline is logged on its own.
+
+// what gets counted, each priced per unit in ENERGY_COSTS
+typedef enum {
+  ENERGY_REDRAW,         // root layer frames
+  ENERGY_EFFECT_PIXELS,  // pixels run through effect chains
+  ENERGY_VIBE_MS,        // vibration motor on time
+  ENERGY_TIMER_WAKEUP,   // AppTimer callbacks
+  ENERGY_TICK,           // tick service wakeups
+  ENERGY_MESSAGE,        // AppMessages sent or received
+  ENERGY_SPAN_PIXELS,    // pixels glyph_draw and the hand rasterizer write
+  ENERGY_EVENT_COUNT
+} EnergyEvent;
+
+#define ENERGY_HISTORY_HOURS 24
+// battery capacity: Pebble Time on basalt, Pebble and Pebble 2 on aplite and
+// diorite (a Pebble Steel's 150 mAh also runs aplite and is taken for 130)
+#ifdef PBL_PLATFORM_BASALT
+#define ENERGY_BATTERY_MAH 150
+#else
+#define ENERGY_BATTERY_MAH 130
+#endif
+#define ENERGY_LONG_PULSE_MS 500  // vibes_long_pulse
+
+// persist keys of the history, one per hour slot (settings use 0-5 and 100)
+#define PERSIST_KEY_ENERGY_HOURS 200
+
+// one hour of the history, as persisted
+typedef struct {
+  uint32_t hour;                        // time() / 3600
+  uint32_t counts[ENERGY_EVENT_COUNT];
+  uint8_t  charge_start;                // percent
+  uint8_t  charge_end;
+  bool     charged;                     // plugged in at some point, so its drain says nothing
+} EnergyHour;
+
+#ifdef ENERGY
+
+//resumes the current hour if it was persisted
+void energy_init(void);
+//persists the current hour
+void energy_deinit(void);
+
+//adds amount units of event to the current hour
+void energy_count(EnergyEvent event, uint32_t amount);
+
+//counts a tick; closes, persists and reports the hour once it is over
+void energy_tick(struct tm *tick_time);
+
+//follows the charge for the drain of the current hour
+void energy_battery(BatteryChargeState charge);
+
+#else
+
+#define energy_init()
+#define energy_deinit()
+#define energy_count(event, amount)
+#define energy_tick(tick_time)
+#define energy_battery(charge)
+
+#endif
@@ -0,0 +1,96 @@
+#include <pebble.h>
+#include "glyph.h"
+#include "theme.h"
+#include "overdraw.h"
+#include "energy.h"
+#include "raster.h"
+
+#define GLYPH_HEADER_SIZE 4
+
+Glyph *glyph_create_with_resource(uint32_t resource_id) {
+  ResHandle handle = resource_get_handle(resource_id);
+  size_t size = resource_size(handle);
+  if (size < GLYPH_HEADER_SIZE) {
+    return NULL;
+  }
+
+  Glyph *glyph = malloc(sizeof(Glyph) + size);
+  if (!glyph) {
+    return NULL;
+  }
+  resource_load(handle, glyph->data, size);
+
+  glyph->size = GSize(glyph->data[0], glyph->data[1]);
+  glyph->span_count = glyph->data[2] | glyph->data[3] << 8;
+  glyph->row_start = (const uint16_t *)(glyph->data + GLYPH_HEADER_SIZE);
+  glyph->spans = (const GlyphSpan *)(glyph->row_start + glyph->size.h + 1);
+
+  size_t expected = GLYPH_HEADER_SIZE + (glyph->size.h + 1) * sizeof(uint16_t) + glyph->span_count * sizeof(GlyphSpan);
+  if (size != expected || glyph->row_start[glyph->size.h] != glyph->span_count) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Malformed glyph resource %d", (int)resource_id);
+    free(glyph);
+    return NULL;
+  }
+  return glyph;
+}
+
+void glyph_destroy(Glyph *glyph) {
+  free(glyph);
+}
+
+void glyph_draw(GContext *ctx, const Glyph *glyph, GPoint origin, GRect clip, GColor8 ink, bool inverted) {
+  if (!glyph) {
+    return;
+  }
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (!fb) {
+    return;
+  }
+  if (gbitmap_get_format(fb) != PBL_IF_BW_ELSE(GBitmapFormat1Bit, PBL_IF_ROUND_ELSE(GBitmapFormat8BitCircular, GBitmapFormat8Bit))) {
+    graphics_release_frame_buffer(ctx, fb);
+    return;
+  }
+  grect_clip(&clip, &(GRect){ .origin = origin, .size = glyph->size });
+  GRect bounds = gbitmap_get_bounds(fb);
+  grect_clip(&clip, &bounds);
+
+  uint8_t *data = gbitmap_get_data(fb);
+  uint16_t bytes_per_row = gbitmap_get_bytes_per_row(fb);
+
+  for (int y = clip.origin.y; y < clip.origin.y + clip.size.h; y++) {
+    int row = y - origin.y;
+    int min_x = clip.origin.x, max_x = clip.origin.x + clip.size.w;
+    uint8_t *line = data + y * bytes_per_row;
+#if defined(PBL_ROUND)
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+    line = info.data;
+    min_x = MAX(min_x, info.min_x);
+    max_x = MIN(max_x, info.max_x + 1);
+#endif
+
+    for (int i = glyph->row_start[row]; i < glyph->row_start[row + 1]; i++) {
+      const GlyphSpan *span = &glyph->spans[i];
+      int x0 = MAX(origin.x + span->x, min_x);
+      int x1 = MIN(origin.x + span->x + span->length, max_x);
+      if (x0 >= x1) {
+        continue;
+      }
+      overdraw_account_rect(GRect(x0, y, x1 - x0, 1));
+      energy_count(ENERGY_SPAN_PIXELS, x1 - x0);
+
+      uint8_t color = span->color;
+      if (color == GColorWhiteARGB8) {
+        color = ink.argb;
+      } else if (inverted) {
+        color = theme_invert_color((GColor8){ .argb = color }).argb;
+      }
+#ifdef PBL_BW
+      raster_fill_bits(line, x0, x1, raster_is_light((GColor8){ .argb = color }));
+#else
+      memset(line + x0, color, x1 - x0);
+#endif
+    }
+  }
+
+  graphics_release_frame_buffer(ctx, fb);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <pebble.h>
+
+// Glyphs stored as runs of opaque pixels, one list per row, encoded from PNGs
+// by the wscript. Drawing writes the runs straight into the framebuffer with
+// memset and never visits transparent pixels, where a GCompOpSet BitmapLayer
+// blends every pixel of its frame; test/bench.c times both. The 58x70 time
+// digits take 338 to 476 bytes of spans against 560 bytes of pixels as 1 bit
+// palette bitmaps, so the gain is mostly in drawing.
+
+// a run of pixels of one color
+typedef struct {
+  uint8_t x;
+  uint8_t length;
+  uint8_t color;  // GColor8 argb, always opaque
+} GlyphSpan;
+
+typedef struct {
+  GSize size;
+  uint16_t span_count;
+  const uint16_t *row_start;  // index of the first span of each row, size.h + 1 entries
+  const GlyphSpan *spans;
+  uint8_t data[];             // the resource as loaded
+} Glyph;
+
+//loads a glyph resource; NULL if it can't be allocated or is malformed
+Glyph *glyph_create_with_resource(uint32_t resource_id);
+
+void glyph_destroy(Glyph *glyph);
+
+//draws glyph with its top left corner at origin, in framebuffer coordinates,
+//touching only pixels inside clip. White runs are drawn in ink, any other
+//color is mapped like theme_invert_color if inverted
+void glyph_draw(GContext *ctx, const Glyph *glyph, GPoint origin, GRect clip, GColor8 ink, bool inverted);
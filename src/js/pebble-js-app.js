@@ -1,32 +1,236 @@
+var CONFIG_PROTOCOL_VERSION = 1;
+
+// Quantizes '#RRGGBB' or '0xRRGGBB' to a GColor8 argb byte (opaque, 2 bits per channel)
+function colorToGColor8(color) {
+  var rgb = parseInt(color.replace(/^(#|0x)/, ''), 16);
+  return 0xC0 |
+    (((rgb >> 22) & 0x3) << 4) |
+    (((rgb >> 14) & 0x3) << 2) |
+    ((rgb >> 6) & 0x3);
+}
+
+// Telemetry sent by --telemetry builds, one KEY_TELEMETRY byte array laid out
+// as TelemetryPayload in telemetry.h. Summaries are kept in localStorage so
+// they survive restarts of the phone app. With a telemetry address set on the
+// settings page, the ones not exported yet are POSTed to it as CSV.
+var TELEMETRY_STORAGE_KEY = 'telemetry';
+var TELEMETRY_EXPORTED_KEY = 'telemetryExported'; // received time of the last sample exported
+var TELEMETRY_MAX_SAMPLES = 672; // a week of 15 minute summaries
+var TELEMETRY_PAYLOAD_SIZE = 29;
+var TELEMETRY_FIELDS = [
+  'received', 'platform', 'version', 'minutes', 'frames', 'frameMsAvg', 'frameMsMax',
+  'effectRuns', 'effectMsAvg', 'effectMsMax', 'ticks', 'tickMsAvg', 'tickMsMax',
+  'heapPeak', 'heapUsed'
+];
+
+function readUint16(bytes, offset) {
+  return bytes[offset] | (bytes[offset + 1] << 8);
+}
+
+function readUint32(bytes, offset) {
+  return readUint16(bytes, offset) + readUint16(bytes, offset + 2) * 65536;
+}
+
+// null for payloads this version doesn't understand; newer ones only append fields
+function decodeTelemetry(bytes) {
+  if (!bytes || bytes.length < TELEMETRY_PAYLOAD_SIZE || bytes[0] < 1) {
+    return null;
+  }
+  return {
+    version: bytes[0],
+    minutes: readUint16(bytes, 1),
+    frames: readUint16(bytes, 3),
+    frameMsAvg: readUint16(bytes, 5),
+    frameMsMax: readUint16(bytes, 7),
+    effectRuns: readUint16(bytes, 9),
+    effectMsAvg: readUint16(bytes, 11),
+    effectMsMax: readUint16(bytes, 13),
+    ticks: readUint16(bytes, 15),
+    tickMsAvg: readUint16(bytes, 17),
+    tickMsMax: readUint16(bytes, 19),
+    heapPeak: readUint32(bytes, 21),
+    heapUsed: readUint32(bytes, 25)
+  };
+}
+
+function loadTelemetry() {
+  try {
+    return JSON.parse(localStorage.getItem(TELEMETRY_STORAGE_KEY)) || [];
+  } catch (e) {
+    return [];
+  }
+}
+
+function storeTelemetry(sample) {
+  var samples = loadTelemetry();
+  samples.push(sample);
+  if (samples.length > TELEMETRY_MAX_SAMPLES) {
+    samples.splice(0, samples.length - TELEMETRY_MAX_SAMPLES);
+  }
+  localStorage.setItem(TELEMETRY_STORAGE_KEY, JSON.stringify(samples));
+  return samples;
+}
+
+// one summary over all samples: averages weighted by their counts, worst cases and totals
+function summarizeTelemetry(samples) {
+  var summary = { samples: samples.length, minutes: 0, frames: 0, effectRuns: 0, ticks: 0,
+                  frameMsAvg: 0, frameMsMax: 0, effectMsAvg: 0, effectMsMax: 0,
+                  tickMsAvg: 0, tickMsMax: 0, heapPeak: 0 };
+  var frameMs = 0, effectMs = 0, tickMs = 0;
+  samples.forEach(function(sample) {
+    summary.minutes += sample.minutes;
+    summary.frames += sample.frames;
+    summary.effectRuns += sample.effectRuns;
+    summary.ticks += sample.ticks;
+    frameMs += sample.frameMsAvg * sample.frames;
+    effectMs += sample.effectMsAvg * sample.effectRuns;
+    tickMs += sample.tickMsAvg * sample.ticks;
+    summary.frameMsMax = Math.max(summary.frameMsMax, sample.frameMsMax);
+    summary.effectMsMax = Math.max(summary.effectMsMax, sample.effectMsMax);
+    summary.tickMsMax = Math.max(summary.tickMsMax, sample.tickMsMax);
+    summary.heapPeak = Math.max(summary.heapPeak, sample.heapPeak);
+  });
+  summary.frameMsAvg = summary.frames ? Math.round(frameMs / summary.frames) : 0;
+  summary.effectMsAvg = summary.effectRuns ? Math.round(effectMs / summary.effectRuns) : 0;
+  summary.tickMsAvg = summary.ticks ? Math.round(tickMs / summary.ticks) : 0;
+  return summary;
+}
+
+// samples as CSV, one row per summary
+function telemetryCSV(samples) {
+  var rows = [TELEMETRY_FIELDS.join(',')];
+  samples.forEach(function(sample) {
+    rows.push(TELEMETRY_FIELDS.map(function(field) {
+      return sample[field] === undefined ? '' : sample[field];
+    }).join(','));
+  });
+  return rows.join('\n');
+}
+
+// POSTs the samples received since the last export to url; a failed request
+// leaves them to go out with the next one
+function exportTelemetry(url) {
+  var exported = localStorage.getItem(TELEMETRY_EXPORTED_KEY) || '';
+  var samples = loadTelemetry().filter(function(sample) {
+    return sample.received > exported;
+  });
+  if (!url || samples.length === 0) {
+    return;
+  }
+  var last = samples[samples.length - 1].received;
+  var request = new XMLHttpRequest();
+  request.open('POST', url);
+  request.setRequestHeader('Content-Type', 'text/csv');
+  request.onload = function() {
+    if (request.status >= 200 && request.status < 300) {
+      localStorage.setItem(TELEMETRY_EXPORTED_KEY, last);
+      console.log('Telemetry exported: ' + samples.length + ' samples');
+    } else {
+      console.log('Telemetry export failed: HTTP ' + request.status);
+    }
+  };
+  request.onerror = function() {
+    console.log('Telemetry export failed');
+  };
+  request.send(telemetryCSV(samples));
+}
+
+function watchPlatform() {
+  var info = Pebble.getActiveWatchInfo ? Pebble.getActiveWatchInfo() : null;
+  return info ? info.platform : 'unknown';
+}
+
+// battery percent the watch starts saving power at, 0 turns it off
+function powerSaverPercent(value) {
+  var percent = parseInt(value, 10);
+  return isNaN(percent) ? 20 : Math.max(0, Math.min(100, percent));
+}
+
 Pebble.addEventListener('ready', function() {
   console.log('PebbleKit JS ready!');
+  var samples = loadTelemetry();
+  if (samples.length > 0) {
+    console.log('Telemetry summary: ' + JSON.stringify(summarizeTelemetry(samples)));
+  }
 });
 
-Pebble.addEventListener('showConfiguration', function() {
-  var url = 'https://rawgit.com/nikojo/BigTimeColor/master/config/index.html';
-  console.log('Showing configuration page: ' + url);
+Pebble.addEventListener('appmessage', function(e) {
+  var sample = decodeTelemetry(e.payload.KEY_TELEMETRY);
+  if (!sample) {
+    return;
+  }
+  sample.received = new Date().toISOString();
+  sample.platform = watchPlatform();
+  var samples = storeTelemetry(sample);
+  console.log('Telemetry: ' + JSON.stringify(sample) + ', ' + samples.length + ' stored');
+  exportTelemetry(telemetryURL());
+});
+
+// Settings last sent to the watch, so the page opens showing what the watch has.
+// The page is a data: URI without storage of its own.
+var CONFIG_STORAGE_KEY = 'config';
 
+function loadConfig() {
+  try {
+    return JSON.parse(localStorage.getItem(CONFIG_STORAGE_KEY));
+  } catch (e) {
+    return null;
+  }
+}
+
+// where telemetry is exported to, set on the settings page; empty keeps it on the phone
+function telemetryURL() {
+  var config = loadConfig();
+  return (config && config['telemetry_url']) || '';
+}
+
+// JSON that can sit inside an inline <script>: no '<' to end the script or
+// open a comment, no line separators older engines reject in string literals
+function scriptSafeJSON(value) {
+  return JSON.stringify(value)
+    .replace(/</g, '\\u003c')
+    .replace(/\u2028/g, '\\u2028')
+    .replace(/\u2029/g, '\\u2029');
+}
+
+// CONFIG_PAGE_HTML is config/index.html with everything inlined, see the wscript
+function configPageURL() {
+  // a function, so '$' in stored strings isn't taken as a replacement pattern
+  var settings = scriptSafeJSON(loadConfig());
+  var html = CONFIG_PAGE_HTML.replace('/*WATCH_SETTINGS*/null', function() { return settings; });
+  return 'data:text/html;charset=utf-8,' + encodeURIComponent(html);
+}
+
+Pebble.addEventListener('showConfiguration', function() {
+  var url = configPageURL();
+  console.log('Showing configuration page, ' + url.length + ' characters');
   Pebble.openURL(url);
 });
 
 Pebble.addEventListener('webviewclosed', function(e) {
+  // closed without submitting
+  if (!e.response) {
+    return;
+  }
   var configData = JSON.parse(decodeURIComponent(e.response));
   console.log('Configuration page returned: ' + JSON.stringify(configData));
   
-  var minuteColor = configData['minute_hand_color'];
-  var hourColor = configData['hour_hand_color'];
-
+  // One byte-array tuple, laid out as the CONFIG_BYTE_* enum in settings.h
   var dict = {};
-  dict.KEY_MINUTE_COLOR_R = parseInt(minuteColor.substring(2, 4), 16);
-  dict.KEY_MINUTE_COLOR_G = parseInt(minuteColor.substring(4, 6), 16);
-  dict.KEY_MINUTE_COLOR_B = parseInt(minuteColor.substring(6), 16);
-  dict.KEY_HOUR_COLOR_R = parseInt(hourColor.substring(2, 4), 16);
-  dict.KEY_HOUR_COLOR_G = parseInt(hourColor.substring(4, 6), 16);
-  dict.KEY_HOUR_COLOR_B = parseInt(hourColor.substring(6), 16);
+  dict.KEY_CONFIG = [
+    CONFIG_PROTOCOL_VERSION,
+    colorToGColor8(configData['minute_hand_color']),
+    colorToGColor8(configData['hour_hand_color']),
+    colorToGColor8(configData['digit_color'] || '#FFFFFF'),
+    powerSaverPercent(configData['power_saver_percent'])
+  ];
   
   // Send to watchapp
   Pebble.sendAppMessage(dict, function() {
     console.log('Send successful: ' + JSON.stringify(dict));
+    localStorage.setItem(CONFIG_STORAGE_KEY, JSON.stringify(configData));
+    // a newly set address gets what is stored so far
+    exportTelemetry(telemetryURL());
   }, function() {
     console.log('Send failed!');
   });
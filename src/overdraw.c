@@ -0,0 +1,131 @@
+#include <pebble.h>
+#include "overdraw.h"
+
+#ifdef OVERDRAW
+
+#define OVERDRAW_WIDTH 144
+#define OVERDRAW_HEIGHT 168
+
+static const char *SOURCE_NAMES[OVERDRAW_SOURCE_COUNT] = {
+  "fill", "hands", "glyphs", "effect0", "effect1", "effect2", "effect3"
+};
+
+static const uint8_t HEATMAP_COLORS[] = {
+  GColorBlackARGB8, 0xC4 /* dark green */, 0xCC /* green */, 0xFC /* yellow */, 0xF8 /* orange */, 0xF0 /* red */
+};
+
+// 1 bit frames only show where a pixel was written more than once
+#define HEATMAP_OVERDRAWN_1BIT 2
+
+static uint8_t *write_counts;    // saturating writes per pixel this frame
+static uint8_t *previous_frame;  // last frame as rendered, before the heatmap
+static bool have_previous;
+
+static OverdrawSource current_source;
+static uint32_t reads[OVERDRAW_SOURCE_COUNT];
+static uint32_t writes[OVERDRAW_SOURCE_COUNT];
+
+void overdraw_init(void) {
+  write_counts = malloc(OVERDRAW_WIDTH * OVERDRAW_HEIGHT);
+  previous_frame = malloc(OVERDRAW_WIDTH * OVERDRAW_HEIGHT);
+  if (!write_counts || !previous_frame) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Not enough heap for overdraw buffers, instrumentation disabled");
+    overdraw_deinit();
+  }
+  have_previous = false;
+}
+
+void overdraw_deinit(void) {
+  free(write_counts);
+  free(previous_frame);
+  write_counts = previous_frame = NULL;
+}
+
+void overdraw_frame_begin(void) {
+  if (write_counts) memset(write_counts, 0, OVERDRAW_WIDTH * OVERDRAW_HEIGHT);
+  memset(reads, 0, sizeof(reads));
+  memset(writes, 0, sizeof(writes));
+  current_source = OVERDRAW_SOURCE_FILL;
+}
+
+void overdraw_set_source(OverdrawSource source) {
+  current_source = source < OVERDRAW_SOURCE_COUNT ? source : OVERDRAW_SOURCE_COUNT - 1;
+}
+
+void overdraw_read(int x, int y) {
+  ++reads[current_source];
+}
+
+void overdraw_write(int x, int y) {
+  ++writes[current_source];
+  if (write_counts && x >= 0 && x < OVERDRAW_WIDTH && y >= 0 && y < OVERDRAW_HEIGHT) {
+    uint8_t *count = &write_counts[y * OVERDRAW_WIDTH + x];
+    if (*count < 0xFF) ++*count;
+  }
+}
+
+void overdraw_account_rect(GRect rect) {
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++)
+    for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++)
+      overdraw_write(x, y);
+}
+
+#ifdef PBL_COLOR
+#define FRAME_FORMAT GBitmapFormat8Bit
+
+static uint8_t frame_get(uint8_t *row, int x) {
+  return row[x];
+}
+
+static void frame_put_heat(uint8_t *row, int x, uint8_t count) {
+  row[x] = HEATMAP_COLORS[MIN(count, ARRAY_LENGTH(HEATMAP_COLORS) - 1)];
+}
+#else
+#define FRAME_FORMAT GBitmapFormat1Bit
+
+static uint8_t frame_get(uint8_t *row, int x) {
+  return (row[x / 8] >> (x % 8)) & 1;
+}
+
+static void frame_put_heat(uint8_t *row, int x, uint8_t count) {
+  if (count >= HEATMAP_OVERDRAWN_1BIT) row[x / 8] |= 1 << (x % 8);
+  else row[x / 8] &= ~(1 << (x % 8));
+}
+#endif
+
+void overdraw_frame_end(GContext *ctx) {
+  if (!write_counts) {
+    return;
+  }
+
+  GBitmap *fb = graphics_capture_frame_buffer_format(ctx, FRAME_FORMAT);
+  uint8_t *data = gbitmap_get_data(fb);
+  int bytes_per_row = gbitmap_get_bytes_per_row(fb);
+
+  uint32_t changed = 0, touched = 0, written = 0;
+  for (int y = 0; y < OVERDRAW_HEIGHT; y++) {
+    uint8_t *row = &data[y * bytes_per_row];
+    uint8_t *previous = &previous_frame[y * OVERDRAW_WIDTH];
+    uint8_t *counts = &write_counts[y * OVERDRAW_WIDTH];
+    for (int x = 0; x < OVERDRAW_WIDTH; x++) {
+      uint8_t pixel = frame_get(row, x);
+      if (!have_previous || pixel != previous[x]) ++changed;
+      if (counts[x]) ++touched;
+      written += counts[x];
+      previous[x] = pixel;
+      frame_put_heat(row, x, counts[x]);
+    }
+  }
+  have_previous = true;
+  graphics_release_frame_buffer(ctx, fb);
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "overdraw written=%d touched=%d changed=%d efficiency=%d%%",
+    (int)written, (int)touched, (int)changed, written ? (int)(100 * changed / written) : 100);
+  for (int i = 0; i < OVERDRAW_SOURCE_COUNT; i++) {
+    if (reads[i] || writes[i]) {
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "  %s reads=%d writes=%d", SOURCE_NAMES[i], (int)reads[i], (int)writes[i]);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+#include <pebble.h>
+#include "effect_layer.h"
+
+// Overdraw instrumentation, only compiled into builds configured with --overdraw.
+// Counts framebuffer reads and writes per pixel and per source for every frame,
+// and how many pixels actually differ from the previous frame. Each frame is
+// summarized in the log and replaced on screen by a heatmap of its writes
+// (black: untouched, green: once, yellow: twice, orange: three times, red: more;
+// on black & white platforms white: more than once).
+// Areas drawn by the SDK (fills, glyph layers) are accounted by the caller;
+// effect kernels count themselves through their pixel accessors, and glyph
+// and hand spans as they write them.
+
+typedef enum {
+  OVERDRAW_SOURCE_FILL,
+  OVERDRAW_SOURCE_HANDS,
+  OVERDRAW_SOURCE_GLYPHS,
+  OVERDRAW_SOURCE_EFFECTS, // first effect of an EffectLayer chain, the rest follow
+  OVERDRAW_SOURCE_COUNT = OVERDRAW_SOURCE_EFFECTS + MAX_EFFECTS
+} OverdrawSource;
+
+#ifdef OVERDRAW
+
+void overdraw_init(void);
+void overdraw_deinit(void);
+
+//resets the per-frame counters
+void overdraw_frame_begin(void);
+
+//compares with the previous frame, logs the summary and paints the heatmap
+void overdraw_frame_end(GContext *ctx);
+
+//attributes the following reads and writes to source
+void overdraw_set_source(OverdrawSource source);
+
+//framebuffer accesses, in framebuffer coordinates
+void overdraw_read(int x, int y);
+void overdraw_write(int x, int y);
+
+//areas written by SDK drawing calls, or spans written directly
+void overdraw_account_rect(GRect rect);
+
+#else
+
+#define overdraw_init()
+#define overdraw_deinit()
+#define overdraw_frame_begin()
+#define overdraw_frame_end(ctx)
+#define overdraw_set_source(source)
+#define overdraw_read(x, y)
+#define overdraw_write(x, y)
+#define overdraw_account_rect(rect)
+
+#endif
@@ -0,0 +1,167 @@
+#include <pebble.h>
+#include "profiler.h"
+#include "overdraw.h"
+
+#ifdef PROFILE
+#undef clock_is_24h_style
+
+// delay between sweep steps, long enough for the frame to be rendered
+#define SWEEP_STEP_MS 40
+#define MINUTES_PER_DAY (24 * 60)
+
+// one sweep pass per scenario
+typedef struct {
+  bool    clock_24h;
+  bool    connected;
+  uint8_t charge_percent;
+  bool    plugged;
+} SweepScenario;
+
+static const SweepScenario SWEEP_SCENARIOS[] = {
+  { true,  true,  100, false },
+  { false, true,  100, false },
+  { true,  true,  30,  false },
+  { true,  true,  10,  false },
+  { true,  true,  50,  true  },
+  { true,  false, 100, false },
+  { false, false, 10,  false },
+};
+#define SWEEP_SCENARIO_COUNT (int)ARRAY_LENGTH(SWEEP_SCENARIOS)
+
+static Layer *probe_layer;
+static ProfilerHooks profiler_hooks;
+
+static time_t frame_start_s;
+static uint16_t frame_start_ms;
+static uint32_t frame_number;
+static size_t previous_heap;
+static size_t peak_heap;
+
+static bool sweeping;
+static int sweep_scenario;
+static int sweep_minute;
+static AppTimer *sweep_timer;
+
+// FNV-1a over the visible framebuffer
+static uint32_t framebuffer_checksum(GContext *ctx) {
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  GRect bounds = gbitmap_get_bounds(fb);
+  uint32_t hash = 2166136261u;
+
+  for (int y = 0; y < bounds.size.h; y++) {
+    #ifndef PBL_PLATFORM_CHALK
+      uint8_t *row = gbitmap_get_data(fb) + y * gbitmap_get_bytes_per_row(fb);
+      int min_x = 0, max_x = gbitmap_get_bytes_per_row(fb) - 1;
+    #else
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+      uint8_t *row = info.data;
+      int min_x = info.min_x, max_x = info.max_x;
+    #endif
+    for (int x = min_x; x <= max_x; x++) {
+      hash = (hash ^ row[x]) * 16777619u;
+    }
+  }
+
+  graphics_release_frame_buffer(ctx, fb);
+  return hash;
+}
+
+// topmost layer, so it is drawn last and sees the finished frame
+static void probe_update_proc(Layer *layer, GContext *ctx) {
+  time_t end_s;
+  uint16_t end_ms;
+  time_ms(&end_s, &end_ms);
+  int render_ms = (end_s - frame_start_s) * 1000 + end_ms - frame_start_ms;
+
+  size_t heap = heap_bytes_used();
+  if (heap > peak_heap) peak_heap = heap;
+
+  uint32_t checksum = framebuffer_checksum(ctx);
+
+  if (sweeping) {
+    const SweepScenario *scenario = &SWEEP_SCENARIOS[sweep_scenario];
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "frame %d/%02d:%02d 24h=%d bt=%d batt=%d%s crc=%08x render=%dms heap=%d delta=%d peak=%d",
+      sweep_scenario, sweep_minute / 60, sweep_minute % 60, scenario->clock_24h, scenario->connected,
+      scenario->charge_percent, scenario->plugged ? "+" : "", (unsigned int)checksum, render_ms,
+      (int)heap, (int)(heap - previous_heap), (int)peak_heap);
+  } else {
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "frame %d crc=%08x render=%dms heap=%d delta=%d peak=%d",
+      (int)frame_number, (unsigned int)checksum, render_ms, (int)heap, (int)(heap - previous_heap), (int)peak_heap);
+  }
+
+  previous_heap = heap;
+  ++frame_number;
+
+  overdraw_frame_end(ctx);
+}
+
+void profiler_frame_begin(void) {
+  time_ms(&frame_start_s, &frame_start_ms);
+  overdraw_frame_begin();
+}
+
+bool profiler_clock_is_24h_style(void) {
+  return sweeping ? SWEEP_SCENARIOS[sweep_scenario].clock_24h : clock_is_24h_style();
+}
+
+#ifdef PROFILE_SWEEP
+static void apply_scenario(const SweepScenario *scenario) {
+  profiler_hooks.battery((BatteryChargeState) {
+    .charge_percent = scenario->charge_percent,
+    .is_charging = scenario->plugged,
+    .is_plugged = scenario->plugged
+  });
+  profiler_hooks.connection(scenario->connected);
+}
+
+// feeds the next minute of the sweep through the tick handler
+static void sweep_step(void *data) {
+  // a fixed date, so only the time and scenario change between passes
+  struct tm tick_time = {
+    .tm_year = 116, .tm_mon = 11, .tm_mday = 31, .tm_wday = 6,
+    .tm_hour = sweep_minute / 60, .tm_min = sweep_minute % 60
+  };
+  TimeUnits units = MINUTE_UNIT | HOUR_UNIT;
+  if (sweep_minute == 0) {
+    units |= DAY_UNIT | MONTH_UNIT | YEAR_UNIT;
+    apply_scenario(&SWEEP_SCENARIOS[sweep_scenario]);
+  }
+  profiler_hooks.tick(&tick_time, units);
+
+  if (++sweep_minute == MINUTES_PER_DAY) {
+    sweep_minute = 0;
+    if (++sweep_scenario == SWEEP_SCENARIO_COUNT) {
+      APP_LOG(APP_LOG_LEVEL_INFO, "Sweep done: %d frames, peak heap %d", (int)frame_number, (int)peak_heap);
+      sweeping = false;
+      sweep_timer = NULL;
+      return;
+    }
+  }
+  sweep_timer = app_timer_register(SWEEP_STEP_MS, sweep_step, NULL);
+}
+#endif
+
+void profiler_init(Layer *root, const ProfilerHooks *hooks) {
+  profiler_hooks = *hooks;
+  probe_layer = layer_create(layer_get_bounds(root));
+  layer_set_update_proc(probe_layer, probe_update_proc);
+  layer_add_child(root, probe_layer);
+  previous_heap = peak_heap = heap_bytes_used();
+  overdraw_init();
+
+#ifdef PROFILE_SWEEP
+  sweeping = true;
+  sweep_timer = app_timer_register(SWEEP_STEP_MS, sweep_step, NULL);
+#endif
+}
+
+void profiler_deinit(void) {
+  if (sweep_timer) {
+    app_timer_cancel(sweep_timer);
+    sweep_timer = NULL;
+  }
+  layer_destroy(probe_layer);
+  overdraw_deinit();
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <pebble.h>
+
+// Frame profiler, only compiled into builds configured with --profile.
+// Every frame is logged with its render time, heap usage and a checksum of
+// the framebuffer, so two builds can be compared frame by frame.
+//
+// --profile-sweep additionally replays all 1440 minutes of a day for each
+// combination of clock style, connection and battery state through the
+// real handlers, giving a golden log every renderer change can be diffed against.
+
+// hooks the sweep drives, all of them the app's real handlers
+typedef struct {
+  void (*tick)(struct tm *tick_time, TimeUnits units_changed);
+  void (*battery)(BatteryChargeState charge);
+  void (*connection)(bool connected);  // false enters fail mode immediately
+} ProfilerHooks;
+
+#ifdef PROFILE
+
+//adds the frame-end probe on top of root and starts the sweep if enabled
+void profiler_init(Layer *root, const ProfilerHooks *hooks);
+void profiler_deinit(void);
+
+//marks the start of a frame, call first thing in the root layer update proc
+void profiler_frame_begin(void);
+
+//clock style, overridden while sweeping
+bool profiler_clock_is_24h_style(void);
+#define clock_is_24h_style profiler_clock_is_24h_style
+
+#else
+
+#define profiler_init(root, hooks)
+#define profiler_deinit()
+#define profiler_frame_begin()
+
+#endif
@@ -0,0 +1,214 @@
+#include <pebble.h>
+#include "raster.h"
+#include "overdraw.h"
+#include "energy.h"
+
+// half width of each row of a disc, row 0 through the center, as a midpoint
+// circle fills it (see midpoint_half_widths)
+static const uint8_t HALF_WIDTHS_20[] = { 20, 20, 20, 20, 20, 19, 19, 19, 18, 18, 17, 17, 16, 15, 14, 13, 12, 11, 9, 7, 4 };
+static const uint8_t HALF_WIDTHS_15[] = { 15, 15, 15, 15, 14, 14, 14, 13, 13, 12, 11, 10, 9, 8, 6, 3 };
+static const uint8_t HALF_WIDTHS_6[]  = { 6, 6, 6, 5, 4, 3, 2 };
+static const uint8_t HALF_WIDTHS_5[]  = { 5, 5, 5, 4, 3, 2 };
+
+static const uint8_t *half_widths(int radius) {
+  switch (radius) {
+    case 20: return HALF_WIDTHS_20;
+    case 15: return HALF_WIDTHS_15;
+    case 6:  return HALF_WIDTHS_6;
+    case 5:  return HALF_WIDTHS_5;
+    default: return NULL;
+  }
+}
+
+// the midpoint circle steps through one octant; each step (x, y) fills
+// columns +-x over rows +-y and columns +-y over rows +-x
+static void midpoint_half_widths(int radius, uint8_t *half) {
+  memset(half, 0, radius + 1);
+  int f = 1 - radius, ddf_x = 1, ddf_y = -2 * radius;
+  int x = 0, y = radius;
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddf_y += 2;
+      f += ddf_y;
+    }
+    x++;
+    ddf_x += 2;
+    f += ddf_x;
+    for (int row = 0; row <= y; row++) half[row] = MAX(half[row], x);
+    for (int row = 0; row <= x; row++) half[row] = MAX(half[row], y);
+  }
+}
+
+static int isqrt(int n) {
+  int root = 0;
+  for (int bit = 1 << 14; bit; bit >>= 1) {
+    if ((root + bit) * (root + bit) <= n) root += bit;
+  }
+  return root;
+}
+
+bool raster_is_light(GColor8 color) {
+  return ((color.argb >> 4) & 3) + ((color.argb >> 2) & 3) + (color.argb & 3) >= 5;
+}
+
+#ifdef PBL_BW
+void raster_fill_bits(uint8_t *row, int x0, int x1, bool white) {
+  int first = x0 / 8, last = (x1 - 1) / 8;
+  uint8_t head = 0xFF << (x0 % 8);
+  uint8_t tail = 0xFF >> (7 - (x1 - 1) % 8);
+  if (first == last) {
+    head &= tail;
+  }
+  row[first] = white ? row[first] | head : row[first] & ~head;
+  if (first == last) {
+    return;
+  }
+  memset(row + first + 1, white ? 0xFF : 0x00, last - first - 1);
+  row[last] = white ? row[last] | tail : row[last] & ~tail;
+}
+#endif
+
+bool raster_begin(RasterTarget *target, GContext *ctx) {
+  target->fb = graphics_capture_frame_buffer(ctx);
+  if (!target->fb) {
+    return false;
+  }
+  if (gbitmap_get_format(target->fb) != PBL_IF_BW_ELSE(GBitmapFormat1Bit, PBL_IF_ROUND_ELSE(GBitmapFormat8BitCircular, GBitmapFormat8Bit))) {
+    graphics_release_frame_buffer(ctx, target->fb);
+    return false;
+  }
+  target->data = gbitmap_get_data(target->fb);
+  target->bytes_per_row = gbitmap_get_bytes_per_row(target->fb);
+  target->bounds = gbitmap_get_bounds(target->fb);
+  return true;
+}
+
+void raster_end(RasterTarget *target, GContext *ctx) {
+  graphics_release_frame_buffer(ctx, target->fb);
+}
+
+void raster_span(RasterTarget *target, int y, int x0, int x1, GColor8 color) {
+  GRect bounds = target->bounds;
+  if (y < bounds.origin.y || y >= bounds.origin.y + bounds.size.h) {
+    return;
+  }
+  uint8_t *line = target->data + y * target->bytes_per_row;
+#if defined(PBL_ROUND)
+  GBitmapDataRowInfo info = gbitmap_get_data_row_info(target->fb, y);
+  line = info.data;
+  x0 = MAX(x0, info.min_x);
+  x1 = MIN(x1, info.max_x + 1);
+#endif
+  x0 = MAX(x0, bounds.origin.x);
+  x1 = MIN(x1, bounds.origin.x + bounds.size.w);
+  if (x0 >= x1) {
+    return;
+  }
+  overdraw_account_rect(GRect(x0, y, x1 - x0, 1));
+  energy_count(ENERGY_SPAN_PIXELS, x1 - x0);
+
+#ifdef PBL_BW
+  raster_fill_bits(line, x0, x1, raster_is_light(color));
+#else
+  memset(line + x0, color.argb, x1 - x0);
+#endif
+}
+
+void raster_fill_circle(RasterTarget *target, GPoint center, int radius, GColor8 color) {
+  if (radius < 0 || radius > RASTER_MAX_RADIUS) {
+    return;
+  }
+  uint8_t computed[RASTER_MAX_RADIUS + 1];
+  const uint8_t *table = half_widths(radius);
+  if (!table) {
+    midpoint_half_widths(radius, computed);
+    table = computed;
+  }
+  for (int dy = -radius; dy <= radius; dy++) {
+    int half = table[abs(dy)];
+    raster_span(target, center.y + dy, center.x - half, center.x + half + 1, color);
+  }
+}
+
+// a / b rounded down and up, for any signs
+static int floor_div(int a, int b) {
+  int q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+static int ceil_div(int a, int b) {
+  return -floor_div(-a, b);
+}
+
+// Bresenham, the pixels of one row written as one run
+static void line_1px(RasterTarget *target, GPoint p0, GPoint p1, GColor8 color) {
+  int dx = abs(p1.x - p0.x), sx = p0.x < p1.x ? 1 : -1;
+  int dy = -abs(p1.y - p0.y), sy = p0.y < p1.y ? 1 : -1;
+  int error = dx + dy;
+  int x = p0.x, y = p0.y, run_start = x;
+  for (;;) {
+    bool last = x == p1.x && y == p1.y;
+    int e2 = 2 * error;
+    bool step_y = !last && e2 <= dx;
+    if (last || step_y) {
+      raster_span(target, y, MIN(run_start, x), MAX(run_start, x) + 1, color);
+    }
+    if (last) {
+      return;
+    }
+    if (e2 >= dy) {
+      error += dy;
+      x += sx;
+    }
+    if (step_y) {
+      error += dx;
+      y += sy;
+      run_start = x;
+    }
+  }
+}
+
+void raster_line(RasterTarget *target, GPoint p0, GPoint p1, int width, GColor8 color) {
+  if (width <= 1) {
+    line_1px(target, p0, p1, color);
+    return;
+  }
+  raster_fill_circle(target, p0, width / 2, color);
+  raster_fill_circle(target, p1, width / 2, color);
+
+  int dx = p1.x - p0.x, dy = p1.y - p0.y;
+  int length2 = dx * dx + dy * dy;
+  if (length2 == 0) {
+    return;
+  }
+  // a pixel at (rx, ry) from p0 is inside if its distance from the axis,
+  // |dx * ry - dy * rx| / length, is at most width / 2, and it lies between
+  // the perpendiculars through the ends: 0 <= dx * rx + dy * ry <= length2.
+  // the left sides are integers, so comparing with the floor of the exact
+  // bound width * length / 2 is exact
+  int reach = isqrt(width * width * length2) / 2;
+  int margin = width / 2 + 1;
+  for (int ry = MIN(0, dy) - margin; ry <= MAX(0, dy) + margin; ry++) {
+    int x0 = INT16_MIN, x1 = INT16_MAX;
+    if (dy != 0) {
+      int a = floor_div(dx * ry - reach, dy), b = floor_div(dx * ry + reach, dy);
+      int c = ceil_div(dx * ry - reach, dy), d = ceil_div(dx * ry + reach, dy);
+      x0 = MAX(x0, dy > 0 ? c : d);
+      x1 = MIN(x1, dy > 0 ? b : a);
+    } else if (abs(dx * ry) > reach) {
+      continue;
+    }
+    if (dx != 0) {
+      int lo = dx > 0 ? ceil_div(-dy * ry, dx) : ceil_div(length2 - dy * ry, dx);
+      int hi = dx > 0 ? floor_div(length2 - dy * ry, dx) : floor_div(-dy * ry, dx);
+      x0 = MAX(x0, lo);
+      x1 = MIN(x1, hi);
+    } else if (dy * ry < 0 || dy * ry > length2) {
+      continue;
+    }
+    if (x0 <= x1) {
+      raster_span(target, p0.y + ry, p0.x + x0, p0.x + x1 + 1, color);
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <pebble.h>
+
+// Span rasterizer for the hands. Filled circles and thick lines are written
+// as horizontal runs straight into framebuffer rows, clipped to the screen,
+// instead of going through graphics_fill_circle and stroked graphics_draw_line.
+// Circles are midpoint circles, 1 pixel lines Bresenham and thicker ones round
+// capped, as the model in test/ draws them (see test/raster.c); that is what
+// the SDK is assumed to draw, not something checked against the firmware.
+// Circles of the radii the face uses come from precomputed half-width tables.
+
+#define RASTER_MAX_RADIUS 84
+
+typedef struct {
+  GBitmap  *fb;
+  uint8_t  *data;
+  uint16_t bytes_per_row;
+  GRect    bounds;
+} RasterTarget;
+
+//captures the framebuffer; false if it can't be, or has a format this platform doesn't draw
+bool raster_begin(RasterTarget *target, GContext *ctx);
+
+//releases the framebuffer
+void raster_end(RasterTarget *target, GContext *ctx);
+
+//pixels x0..x1-1 of row y, in framebuffer coordinates
+void raster_span(RasterTarget *target, int y, int x0, int x1, GColor8 color);
+
+//midpoint disc 2 * radius + 1 wide; radius up to RASTER_MAX_RADIUS
+void raster_fill_circle(RasterTarget *target, GPoint center, int radius, GColor8 color);
+
+//line from p0 to p1, width pixels thick measured across it, with round caps
+void raster_line(RasterTarget *target, GPoint p0, GPoint p1, int width, GColor8 color);
+
+//whether a color is drawn white on a 1 bit screen
+bool raster_is_light(GColor8 color);
+
+#ifdef PBL_BW
+//sets or clears bits x0..x1-1 of a packed 1 bit row
+void raster_fill_bits(uint8_t *row, int x0, int x1, bool white);
+#endif
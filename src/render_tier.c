@@ -0,0 +1,48 @@
+#include <pebble.h>
+#include "render_tier.h"
+
+static const RenderTierPolicy POLICIES[RENDER_TIER_COUNT] = {
+  [RENDER_TIER_FULL] = {
+    .animate = true, .effects = true, .prerender = true,
+    .hand_grooves = true, .hand_discs = true, .thin_hands = false
+  },
+  // no transition frames or timers, a tick is a single redraw
+  [RENDER_TIER_SAVER] = {
+    .animate = false, .effects = false, .prerender = false,
+    .hand_grooves = false, .hand_discs = true, .thin_hands = false
+  },
+  // hands as thin lines around the center cap, the fewest pixels written
+  [RENDER_TIER_MINIMAL] = {
+    .animate = false, .effects = false, .prerender = false,
+    .hand_grooves = false, .hand_discs = false, .thin_hands = true
+  },
+};
+
+static const char *NAMES[RENDER_TIER_COUNT] = { "full", "saver", "minimal" };
+
+// tier for a charge without hysteresis, a threshold itself still counts as above it
+static RenderTier tier_at(int percent, uint8_t saver_percent) {
+  if (percent < saver_percent / 2) return RENDER_TIER_MINIMAL;
+  if (percent < saver_percent) return RENDER_TIER_SAVER;
+  return RENDER_TIER_FULL;
+}
+
+RenderTier render_tier_for_charge(RenderTier current, BatteryChargeState charge, uint8_t saver_percent) {
+  if (saver_percent == 0 || charge.is_charging || charge.is_plugged) {
+    return RENDER_TIER_FULL;
+  }
+  RenderTier tier = tier_at(charge.charge_percent, saver_percent);
+  // dropping to a cheaper tier is immediate, climbing back needs the margin
+  if (tier < current) {
+    tier = MIN(current, tier_at(charge.charge_percent - RENDER_TIER_HYSTERESIS_PERCENT, saver_percent));
+  }
+  return tier;
+}
+
+const RenderTierPolicy *render_tier_policy(RenderTier tier) {
+  return &POLICIES[tier];
+}
+
+const char *render_tier_name(RenderTier tier) {
+  return NAMES[tier];
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <pebble.h>
+
+// How much the face spends on drawing, chosen from the battery charge. Below
+// the configured percent it drops to SAVER, below half of it to MINIMAL, and
+// it goes back to FULL as soon as the watch is charging. Each tier only ever
+// switches things off, the face shows the same time in all of them.
+
+typedef enum {
+  RENDER_TIER_FULL,
+  RENDER_TIER_SAVER,
+  RENDER_TIER_MINIMAL,
+  RENDER_TIER_COUNT
+} RenderTier;
+
+// a tier is only left once the charge is this far above its threshold,
+// one step of the reported percentage, so it doesn't flap at the boundary
+#define RENDER_TIER_HYSTERESIS_PERCENT 10
+
+typedef struct {
+  bool animate;       // digit slides, hand sweeps and the hour pulse
+  bool effects;       // effect layers are shown
+  bool prerender;     // next minute's digits decoded ahead of the tick
+  bool hand_grooves;  // line through the middle of each hand disc
+  bool hand_discs;    // discs at the end of the hands
+  bool thin_hands;    // hands drawn 1px wide
+} RenderTierPolicy;
+
+//tier for a charge state, staying in current until the charge clears the hysteresis;
+//saver_percent 0 always gives RENDER_TIER_FULL
+RenderTier render_tier_for_charge(RenderTier current, BatteryChargeState charge, uint8_t saver_percent);
+
+//what is drawn in a tier
+const RenderTierPolicy *render_tier_policy(RenderTier tier);
+
+//short name for logs
+const char *render_tier_name(RenderTier tier);
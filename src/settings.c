@@ -0,0 +1,89 @@
+#include <pebble.h>
+#include "settings.h"
+
+// copy of what is currently in flash, so unchanged settings are never rewritten
+static Settings persisted;
+
+static void settings_set_defaults(Settings *settings) {
+  memset(settings, 0, sizeof(Settings));
+  settings->version = SETTINGS_VERSION;
+  settings->minute_color = DEFAULT_MINUTE_COLOR;
+  settings->hour_color = DEFAULT_HOUR_COLOR;
+  settings->digit_color = DEFAULT_DIGIT_COLOR;
+  settings->power_saver_percent = DEFAULT_POWER_SAVER_PERCENT;
+}
+
+// reads one color stored as three legacy int keys
+static GColor8 read_legacy_color(uint32_t key_r, uint32_t key_g, uint32_t key_b, GColor8 fallback) {
+  if (!persist_exists(key_r)) {
+    return fallback;
+  }
+  return GColorFromRGB(persist_read_int(key_r), persist_read_int(key_g), persist_read_int(key_b));
+}
+
+static void delete_legacy_keys(void) {
+  for (uint32_t key = LEGACY_KEY_MINUTE_COLOR_R; key <= LEGACY_KEY_HOUR_COLOR_B; key++) {
+    persist_delete(key);
+  }
+}
+
+void settings_load(Settings *settings) {
+  settings_set_defaults(settings);
+
+  if (persist_exists(PERSIST_KEY_SETTINGS)) {
+    // older (shorter) blobs only overwrite the fields they know about,
+    // anything appended since keeps its default
+    persist_read_data(PERSIST_KEY_SETTINGS, settings, sizeof(Settings));
+    persisted = *settings;
+    if (settings->version != SETTINGS_VERSION) {
+      settings->version = SETTINGS_VERSION;
+      settings_save(settings);
+    }
+    return;
+  }
+
+  // version 0: one persist_write_int per color channel
+  settings->minute_color = read_legacy_color(LEGACY_KEY_MINUTE_COLOR_R, LEGACY_KEY_MINUTE_COLOR_G, LEGACY_KEY_MINUTE_COLOR_B, settings->minute_color);
+  settings->hour_color = read_legacy_color(LEGACY_KEY_HOUR_COLOR_R, LEGACY_KEY_HOUR_COLOR_G, LEGACY_KEY_HOUR_COLOR_B, settings->hour_color);
+
+  // nothing stored yet is the same as defaults stored, no need to write them
+  settings_set_defaults(&persisted);
+  bool defaults = memcmp(&persisted, settings, sizeof(Settings)) == 0;
+  // the legacy keys go only once their colors are safe in the blob, a failed
+  // write leaves them for the next launch to migrate again
+  if (settings_save(settings) || defaults) {
+    delete_legacy_keys();
+  }
+}
+
+bool settings_apply_config(Settings *settings, const uint8_t *data, uint16_t length) {
+  if (length <= CONFIG_BYTE_VERSION || data[CONFIG_BYTE_VERSION] == 0) {
+    return false;
+  }
+  // bytes are already GColor8 argb, no re-quantizing needed
+  if (length > CONFIG_BYTE_MINUTE_COLOR) {
+    settings->minute_color.argb = data[CONFIG_BYTE_MINUTE_COLOR];
+  }
+  if (length > CONFIG_BYTE_HOUR_COLOR) {
+    settings->hour_color.argb = data[CONFIG_BYTE_HOUR_COLOR];
+  }
+  if (length > CONFIG_BYTE_DIGIT_COLOR) {
+    settings->digit_color.argb = data[CONFIG_BYTE_DIGIT_COLOR];
+  }
+  if (length > CONFIG_BYTE_POWER_SAVER) {
+    settings->power_saver_percent = MIN(data[CONFIG_BYTE_POWER_SAVER], 100);
+  }
+  return true;
+}
+
+bool settings_save(const Settings *settings) {
+  if (memcmp(&persisted, settings, sizeof(Settings)) == 0) {
+    return false;
+  }
+  if (persist_write_data(PERSIST_KEY_SETTINGS, settings, sizeof(Settings)) < 0) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Settings write failed!");
+    return false;
+  }
+  persisted = *settings;
+  return true;
+}
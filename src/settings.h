@@ -0,0 +1,68 @@
+#pragma once
+#include <pebble.h>
+
+// AppMessage keys (see appKeys in appinfo.json)
+#define KEY_CONFIG 6
+#define KEY_TELEMETRY 7  // sent by the watch in --telemetry builds, see telemetry.h
+
+// KEY_CONFIG is a byte array, one byte per setting: pre-quantized GColor8 argb
+// values for colors, plain numbers otherwise. Settings are only ever appended,
+// so shorter payloads from an older phone app and longer ones from a newer app
+// both apply cleanly, as long as a newer one fits CONFIG_SPARE_BYTE_COUNT.
+#define CONFIG_PROTOCOL_VERSION 1
+enum {
+  CONFIG_BYTE_VERSION,
+  CONFIG_BYTE_MINUTE_COLOR,
+  CONFIG_BYTE_HOUR_COLOR,
+  CONFIG_BYTE_DIGIT_COLOR,
+  CONFIG_BYTE_POWER_SAVER,  // percent
+  CONFIG_BYTE_COUNT
+};
+
+// room in the inbox for bytes a newer phone app appends, which this version skips
+#define CONFIG_SPARE_BYTE_COUNT 16
+
+// tuples in a config message, one per appKey the phone sends (checked against appinfo.json by wscript)
+#define SETTINGS_TUPLE_COUNT 1
+
+// AppMessage buffers sized for a config message; the watch sends no settings,
+// telemetry adds its own outbox (see TELEMETRY_OUTBOX_SIZE)
+#define SETTINGS_INBOX_SIZE dict_calc_buffer_size(SETTINGS_TUPLE_COUNT, CONFIG_BYTE_COUNT + CONFIG_SPARE_BYTE_COUNT)
+#define SETTINGS_OUTBOX_SIZE 0
+
+// legacy persist keys, one int per color channel, read only for migration
+#define LEGACY_KEY_MINUTE_COLOR_R 0
+#define LEGACY_KEY_MINUTE_COLOR_G 1
+#define LEGACY_KEY_MINUTE_COLOR_B 2
+#define LEGACY_KEY_HOUR_COLOR_R 3
+#define LEGACY_KEY_HOUR_COLOR_G 4
+#define LEGACY_KEY_HOUR_COLOR_B 5
+
+// persist key of the packed settings blob
+#define PERSIST_KEY_SETTINGS 100
+
+// bump when appending fields to Settings; never reorder or remove fields
+#define SETTINGS_VERSION 3
+
+#define DEFAULT_MINUTE_COLOR GColorArmyGreen
+#define DEFAULT_HOUR_COLOR GColorLiberty
+#define DEFAULT_DIGIT_COLOR GColorWhite
+#define DEFAULT_POWER_SAVER_PERCENT 20
+
+// everything the user can configure, persisted with a single write
+typedef struct __attribute__((__packed__)) {
+  uint8_t version;
+  GColor8 minute_color;
+  GColor8 hour_color;
+  GColor8 digit_color;  // version 2
+  uint8_t power_saver_percent;  // version 3, see render_tier.h; 0 never saves
+} Settings;
+
+//loads settings, migrating the legacy per-channel keys if needed
+void settings_load(Settings *settings);
+
+//applies a KEY_CONFIG payload; returns false if it is malformed
+bool settings_apply_config(Settings *settings, const uint8_t *data, uint16_t length);
+
+//persists settings if they differ from what is stored; returns true if written
+bool settings_save(const Settings *settings);
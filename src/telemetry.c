@@ -0,0 +1,127 @@
+#include <pebble.h>
+#include "telemetry.h"
+#include "settings.h"
+
+#ifdef TELEMETRY
+
+// count, total and worst case of one kind of timing over a period
+typedef struct {
+  uint16_t count;
+  uint32_t total_ms;
+  uint16_t max_ms;
+} TimingStat;
+
+static Layer *probe_layer;
+
+static TimingStat frame_stat;
+static TimingStat effect_stat;
+static TimingStat tick_stat;
+static uint16_t period_minutes;
+static size_t peak_heap;
+
+static uint32_t frame_start_ms;
+static uint32_t tick_start_ms;
+static bool tick_pending;  // the tick's frame hasn't been drawn yet
+
+// wall clock in ms, only ever used for differences so wrapping is harmless
+static uint32_t now_ms(void) {
+  time_t s;
+  uint16_t ms;
+  time_ms(&s, &ms);
+  return (uint32_t)s * 1000 + ms;
+}
+
+static void timing_add(TimingStat *stat, uint32_t ms) {
+  if (stat->count == UINT16_MAX) {
+    return;
+  }
+  ++stat->count;
+  stat->total_ms += ms;
+  stat->max_ms = MAX(stat->max_ms, MIN(ms, UINT16_MAX));
+}
+
+static uint16_t timing_average(const TimingStat *stat) {
+  return stat->count ? stat->total_ms / stat->count : 0;
+}
+
+static void telemetry_reset(void) {
+  memset(&frame_stat, 0, sizeof(frame_stat));
+  memset(&effect_stat, 0, sizeof(effect_stat));
+  memset(&tick_stat, 0, sizeof(tick_stat));
+  period_minutes = 0;
+  peak_heap = heap_bytes_used();
+}
+
+// sends the summary of the period; a busy outbox keeps it accumulating into the next one
+static void telemetry_send(void) {
+  TelemetryPayload payload = {
+    .version = TELEMETRY_VERSION,
+    .minutes = period_minutes,
+    .frames = frame_stat.count,
+    .frame_ms_avg = timing_average(&frame_stat),
+    .frame_ms_max = frame_stat.max_ms,
+    .effect_runs = effect_stat.count,
+    .effect_ms_avg = timing_average(&effect_stat),
+    .effect_ms_max = effect_stat.max_ms,
+    .ticks = tick_stat.count,
+    .tick_ms_avg = timing_average(&tick_stat),
+    .tick_ms_max = tick_stat.max_ms,
+    .heap_peak = peak_heap,
+    .heap_used = heap_bytes_used()
+  };
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    return;
+  }
+  dict_write_data(iter, KEY_TELEMETRY, (const uint8_t *)&payload, sizeof(payload));
+  if (app_message_outbox_send() != APP_MSG_OK) {
+    return;
+  }
+  telemetry_reset();
+}
+
+// topmost layer, so it is drawn last and sees the finished frame
+static void probe_update_proc(Layer *layer, GContext *ctx) {
+  uint32_t end_ms = now_ms();
+  timing_add(&frame_stat, end_ms - frame_start_ms);
+  if (tick_pending) {
+    timing_add(&tick_stat, end_ms - tick_start_ms);
+    tick_pending = false;
+  }
+  peak_heap = MAX(peak_heap, heap_bytes_used());
+}
+
+void telemetry_frame_begin(void) {
+  frame_start_ms = now_ms();
+}
+
+void telemetry_tick(struct tm *tick_time) {
+  // a tick whose frame never came (window hidden) isn't counted
+  tick_start_ms = now_ms();
+  tick_pending = true;
+
+  if (period_minutes < UINT16_MAX) {
+    ++period_minutes;
+  }
+  if (tick_time->tm_min % TELEMETRY_PERIOD_MIN == 0) {
+    telemetry_send();
+  }
+}
+
+void telemetry_record_effects(uint16_t elapsed_ms) {
+  timing_add(&effect_stat, elapsed_ms);
+}
+
+void telemetry_init(Layer *root) {
+  probe_layer = layer_create(layer_get_bounds(root));
+  layer_set_update_proc(probe_layer, probe_update_proc);
+  layer_add_child(root, probe_layer);
+  telemetry_reset();
+}
+
+void telemetry_deinit(void) {
+  layer_destroy(probe_layer);
+}
+
+#endif
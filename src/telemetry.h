@@ -0,0 +1,61 @@
+#pragma once
+#include <pebble.h>
+
+// Field telemetry, only compiled into builds configured with --telemetry.
+// Frame times, effect chain times, redraw counts, tick latency (tick handler
+// to the end of the frame it caused) and heap usage are summarized over
+// TELEMETRY_PERIOD_MIN minutes and sent to the phone as one KEY_TELEMETRY
+// byte array, where pebble-js-app.js aggregates and stores them for export.
+// Unlike --profile nothing is logged or checksummed per frame, so it can
+// stay in builds that go out to watches in the field.
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_PERIOD_MIN 15
+
+// KEY_TELEMETRY payload, little endian, decoded by decodeTelemetry in pebble-js-app.js.
+// Fields are only ever appended, bumping TELEMETRY_VERSION
+typedef struct __attribute__((packed)) {
+  uint8_t  version;
+  uint16_t minutes;        // period the summary covers
+  uint16_t frames;         // root layer redraws
+  uint16_t frame_ms_avg;
+  uint16_t frame_ms_max;
+  uint16_t effect_runs;    // effect layer chains run
+  uint16_t effect_ms_avg;
+  uint16_t effect_ms_max;
+  uint16_t ticks;
+  uint16_t tick_ms_avg;
+  uint16_t tick_ms_max;
+  uint32_t heap_peak;      // bytes, highest seen at the end of a frame
+  uint32_t heap_used;      // bytes, when the summary was sent
+} TelemetryPayload;
+
+#ifdef TELEMETRY
+
+// outbox the summary needs on top of the app's own
+#define TELEMETRY_OUTBOX_SIZE dict_calc_buffer_size(1, sizeof(TelemetryPayload))
+
+//adds the frame-end probe on top of root
+void telemetry_init(Layer *root);
+void telemetry_deinit(void);
+
+//marks the start of a frame, call first thing in the root layer update proc
+void telemetry_frame_begin(void);
+
+//marks a minute tick, call first thing in the tick handler; sends the summary once a period is over
+void telemetry_tick(struct tm *tick_time);
+
+//time an effect layer's chain took
+void telemetry_record_effects(uint16_t elapsed_ms);
+
+#else
+
+#define TELEMETRY_OUTBOX_SIZE 0
+
+#define telemetry_init(root)
+#define telemetry_deinit()
+#define telemetry_frame_begin()
+#define telemetry_tick(tick_time)
+#define telemetry_record_effects(elapsed_ms)
+
+#endif
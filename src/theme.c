@@ -0,0 +1,81 @@
+#include <pebble.h>
+#include "theme.h"
+
+// same result as effect_invert: rgb bits flipped, alpha forced opaque
+GColor8 theme_invert_color(GColor8 color) {
+  return (GColor8){ .argb = (uint8_t)(~color.argb) | 0xC0 };
+}
+
+static GColor8 theme_color(GColor8 color, bool inverted) {
+  return inverted ? theme_invert_color(color) : color;
+}
+
+void theme_init(Theme *theme, const Settings *settings, bool inverted) {
+  theme->inverted     = inverted;
+  theme->background   = theme_color(GColorBlack, inverted);
+  theme->minute_hand  = theme_color(COLOR_FALLBACK(settings->minute_color, GColorWhite), inverted);
+  theme->hour_hand    = theme_color(COLOR_FALLBACK(settings->hour_color, GColorWhite), inverted);
+  theme->hand_groove  = theme_color(GColorBlack, inverted);
+  theme->battery_high = theme_color(COLOR_FALLBACK(GColorGreen, GColorWhite), inverted);
+  theme->battery_mid  = theme_color(COLOR_FALLBACK(GColorYellow, GColorWhite), inverted);
+  theme->battery_low  = theme_color(COLOR_FALLBACK(GColorRed, GColorWhite), inverted);
+  theme->digits       = theme_color(COLOR_FALLBACK(settings->digit_color, GColorWhite), inverted);
+#ifdef PBL_COLOR
+  theme->glyph_palette[0] = GColorClear;
+  theme->glyph_palette[1] = theme->digits;
+#endif
+  // 1 bit glyphs have no transparency: white ones are or'ed onto the face, black ones and'ed
+  theme->compositing  = PBL_IF_COLOR_ELSE(GCompOpSet, inverted ? GCompOpAnd : GCompOpOr);
+}
+
+// transparent pixels keep showing the (already inverted) background, so only
+// opaque ones are flipped; rgb only, to stay an involution
+static void invert_opaque(uint8_t *argb) {
+  if (*argb & 0xC0) {
+    *argb ^= 0x3F;
+  }
+}
+
+void theme_invert_bitmap(GBitmap *bitmap) {
+  if (bitmap == NULL) {
+    return;
+  }
+
+  int palette_size = 0;
+  switch (gbitmap_get_format(bitmap)) {
+    case GBitmapFormat1BitPalette: palette_size = 2; break;
+    case GBitmapFormat2BitPalette: palette_size = 4; break;
+    case GBitmapFormat4BitPalette: palette_size = 16; break;
+    default: break;
+  }
+
+  if (palette_size) {
+    // glyphs and icons are palettized, recoloring is a handful of bytes
+    GColor *palette = gbitmap_get_palette(bitmap);
+    for (int i = 0; i < palette_size; ++i) {
+      invert_opaque(&palette[i].argb);
+    }
+    return;
+  }
+
+  GRect bounds = gbitmap_get_bounds(bitmap);
+  uint8_t *data = gbitmap_get_data(bitmap);
+  uint16_t bytes_per_row = gbitmap_get_bytes_per_row(bitmap);
+
+  if (gbitmap_get_format(bitmap) == GBitmapFormat1Bit) {
+    for (int i = 0; i < bytes_per_row * bounds.size.h; ++i) {
+      data[i] = ~data[i];
+    }
+    return;
+  }
+
+  for (int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; ++y) {
+    #ifndef PBL_PLATFORM_CHALK
+      uint8_t *row = &data[y * bytes_per_row];
+      for (int x = bounds.origin.x; x < bounds.origin.x + bounds.size.w; ++x) invert_opaque(&row[x]);
+    #else
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(bitmap, y);
+      for (int x = info.min_x; x <= info.max_x; ++x) invert_opaque(&info.data[x]);
+    #endif
+  }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <pebble.h>
+#include "settings.h"
+
+// every color the watchface draws with, resolved for the current mode
+typedef struct {
+  bool    inverted;     // bluetooth fail mode, colors as if run through effect_invert
+  GColor8 background;
+  GColor8 minute_hand;
+  GColor8 hour_hand;
+  GColor8 hand_groove;  // line drawn through the hand discs
+  GColor8 battery_high;
+  GColor8 battery_mid;
+  GColor8 battery_low;
+  GColor8 digits;       // ink of every glyph
+  GCompOp compositing;  // how glyph bitmaps are drawn over the hands
+#ifdef PBL_COLOR
+  GColor  glyph_palette[2];  // shared by the palettized glyph bitmaps: transparent, digits
+#endif
+} Theme;
+
+//resolves theme colors from settings, optionally inverted; glyph_palette is
+//rewritten in place, so bitmaps sharing it follow without being touched
+void theme_init(Theme *theme, const Settings *settings, bool inverted);
+
+//maps a color the same way effect_invert maps a framebuffer pixel
+GColor8 theme_invert_color(GColor8 color);
+
+//inverts opaque pixels of a bitmap in place (palette entries when it has one);
+//applying it twice restores the original
+void theme_invert_bitmap(GBitmap *bitmap);
@@ -0,0 +1,91 @@
+#include <pebble.h>
+#include "time_state.h"
+#include "profiler.h"  // clock style is overridden while sweeping
+
+void time_state_init(TimeState *state) {
+  memset(state, 0, sizeof(TimeState));
+}
+
+static void time_digits(const struct tm *tick_time, int8_t digits[TIME_STATE_SLOTS]) {
+  int hour = tick_time->tm_hour;
+
+  if (!clock_is_24h_style()) {
+    hour = hour % 12;
+    if (hour == 0) {
+      hour = 12;
+    }
+  }
+
+  digits[0] = hour / 10 ? hour / 10 : TIME_STATE_EMPTY;
+  digits[1] = hour % 10;
+  digits[2] = tick_time->tm_min / 10;
+  digits[3] = tick_time->tm_min % 10;
+}
+
+// tens and ones of a date part, no leading 0
+static void date_part_digits(int value, int8_t digits[2]) {
+  value = value % 100;
+  digits[0] = value / 10 ? value / 10 : TIME_STATE_EMPTY;
+  digits[1] = value % 10;
+}
+
+GPoint time_state_hand_location(const TimeStateLayout *layout, int inset, int angle) {
+  int xcenter = layout->screen.w / 2;
+  int ycenter = layout->screen.h / 2;
+  unsigned int x = 0;
+  unsigned int y = 0;
+  int32_t xsize = (layout->screen.w - 2 * inset) / 2;
+  int32_t ysize = (layout->screen.h - 2 * inset) / 2;
+  unsigned int angle0 = 182 * angle;
+
+  if ((angle >= 228) && (angle < 316)) {
+    x = inset;
+    y = ycenter + (ysize * cos_lookup(angle0) / sin_lookup(angle0));
+  } else if ((angle > 45) && (angle < 136)) {
+    x = layout->screen.w - inset;
+    y = ycenter - (ysize * cos_lookup(angle0) / sin_lookup(angle0));
+  } else if ((angle >= 136) && (angle < 228)) {
+    x = xcenter - (xsize * sin_lookup(angle0) / cos_lookup(angle0));
+    y = layout->screen.h - inset;
+  } else {
+    x = xcenter + (xsize * sin_lookup(angle0) / cos_lookup(angle0));
+    y = inset;
+  }
+  return (GPoint) { .x = x, .y = y };
+}
+
+void time_state_update(TimeState *state, const struct tm *tick_time, const TimeStateLayout *layout) {
+  TimeState next = *state;
+  next.time = *tick_time;
+
+  time_digits(tick_time, next.digits);
+
+  int month = tick_time->tm_mon + 1;
+  int day = tick_time->tm_mday;
+  int left = layout->month_first ? month : day;
+  int right = layout->month_first ? day : month;
+  date_part_digits(left, &next.date_digits[0]);
+  date_part_digits(right, &next.date_digits[2]);
+  next.date_left_digit_count = left > 9 ? 2 : 1;
+  next.date_right_digit_count = right > 9 ? 2 : 1;
+  next.weekday = tick_time->tm_wday;
+
+  next.hour_angle = (tick_time->tm_hour % 12) * 30 + (tick_time->tm_min / 2);
+  next.minute_angle = tick_time->tm_min * 6;
+  next.hour_location = time_state_hand_location(layout, layout->hour_inset, next.hour_angle);
+  next.minute_location = time_state_hand_location(layout, layout->minute_inset, next.minute_angle);
+
+  // the first update after init reports everything
+  uint8_t changes = state->computed ? 0 : TIME_STATE_ALL;
+  if (memcmp(next.digits, state->digits, sizeof(next.digits)) != 0) changes |= TIME_STATE_DIGITS;
+  if (next.time.tm_hour != state->time.tm_hour) changes |= TIME_STATE_HOUR;
+  if (next.hour_angle != state->hour_angle || next.minute_angle != state->minute_angle) changes |= TIME_STATE_HANDS;
+  if (memcmp(next.date_digits, state->date_digits, sizeof(next.date_digits)) != 0) changes |= TIME_STATE_DATE;
+  if (next.date_left_digit_count != state->date_left_digit_count ||
+      next.date_right_digit_count != state->date_right_digit_count) changes |= TIME_STATE_DATE_LAYOUT;
+  if (next.weekday != state->weekday) changes |= TIME_STATE_WEEKDAY;
+
+  next.computed = true;
+  next.changes = changes;
+  *state = next;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <pebble.h>
+
+// Everything the face shows that follows from the time, computed once per tick
+// and shared by the renderers. time_state_update reports which fields changed
+// since the previous tick, so each renderer only touches what it shows.
+
+#define TIME_STATE_EMPTY -1      // digit not shown (leading zero)
+
+#define TIME_STATE_SLOTS 4       // hour tens, hour ones, minute tens, minute ones
+#define TIME_STATE_DATE_SLOTS 4  // tens and ones of the left part, then of the right part
+
+// change mask bits
+#define TIME_STATE_DIGITS       (1 << 0)  // digits
+#define TIME_STATE_HOUR         (1 << 1)  // time.tm_hour
+#define TIME_STATE_HANDS        (1 << 2)  // angles and locations
+#define TIME_STATE_DATE         (1 << 3)  // date_digits
+#define TIME_STATE_DATE_LAYOUT  (1 << 4)  // date digit counts
+#define TIME_STATE_WEEKDAY      (1 << 5)  // weekday
+#define TIME_STATE_ALL          0x3F
+
+// screen geometry and formats the state is computed for
+typedef struct {
+  GSize   screen;
+  uint8_t hour_inset;    // hands sit on the screen rectangle inset by this much
+  uint8_t minute_inset;
+  bool    month_first;   // american date order
+} TimeStateLayout;
+
+typedef struct {
+  bool      computed;        // false until the first update
+  struct tm time;
+  int8_t    digits[TIME_STATE_SLOTS];
+  int8_t    date_digits[TIME_STATE_DATE_SLOTS];
+  uint8_t   date_left_digit_count;
+  uint8_t   date_right_digit_count;
+  uint8_t   weekday;
+  int16_t   hour_angle;      // degrees clockwise from 12
+  int16_t   minute_angle;
+  GPoint    hour_location;   // where each hand meets its disc
+  GPoint    minute_location;
+  uint8_t   changes;         // TIME_STATE_* that differ from the previous tick
+} TimeState;
+
+//the first update after this reports every field as changed
+void time_state_init(TimeState *state);
+
+//recomputes state for tick_time and sets its change mask
+void time_state_update(TimeState *state, const struct tm *tick_time, const TimeStateLayout *layout);
+
+//where a hand at angle meets the rectangle inset from the screen edge
+GPoint time_state_hand_location(const TimeStateLayout *layout, int inset, int angle);
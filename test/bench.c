@@ -0,0 +1,206 @@
+#include <pebble.h>
+#include <time.h>
+#include "harness.h"
+#include "effects.h"
+#include "raster.h"
+#include "glyph.h"
+
+// Times the pixel kernels of effects.c, blur.c, raster.c and glyph.c on the
+// host, against the shim's plain framebuffer. The Makefile builds it once per
+// --opt profile with the kernels and the rest of src/ at that profile's -O
+// levels, and pebble build writes its output to build/<platform>/kernel_times.txt
+// next to function_sizes.txt. The times are the host's, not the watch's: they
+// compare profiles and kernels with each other, not with a frame budget.
+//
+// usage: bench [LABEL]    LABEL goes in the header line
+
+#define XCENTER 72
+#define YCENTER 84
+// each kernel is timed over batches of about this long, best batch reported
+#define BATCH_NS 20000000LL
+#define BATCHES 5
+
+static const GRect SCREEN = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT } };
+// the hour pulse effect layer, see Watchface.c
+static const GRect PULSE = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, 78 } };
+
+static Glyph *glyph;
+// the same glyph as its 1 bit palette PNG loads, for the BitmapLayer path glyphs replaced
+static GBitmap *glyph_bitmap;
+
+typedef struct {
+  const char *name;
+  void (*run)(GContext *ctx);
+  int pixels;  // pixels the kernel covers per call
+  bool color_only;  // a no-op with two colors, not timed on aplite
+} Kernel;
+
+static void run_invert(GContext *ctx) { effect_invert(ctx, SCREEN, NULL); }
+static void run_invert_bw_only(GContext *ctx) { effect_invert_bw_only(ctx, SCREEN, NULL); }
+static void run_invert_brightness(GContext *ctx) { effect_invert_brightness(ctx, SCREEN, NULL); }
+static void run_mirror_vertical(GContext *ctx) { effect_mirror_vertical(ctx, SCREEN, NULL); }
+static void run_mirror_horizontal(GContext *ctx) { effect_mirror_horizontal(ctx, SCREEN, NULL); }
+static void run_rotate_90(GContext *ctx) { effect_rotate_90_degrees(ctx, GRect(0, 0, 144, 144), (void *)true); }
+static void run_zoom(GContext *ctx) { effect_zoom(ctx, PULSE, EL_ZOOM(120, 120)); }
+static void run_lens(GContext *ctx) { effect_lens(ctx, SCREEN, EL_LENS(20, 5)); }
+static void run_blur(GContext *ctx) { effect_blur(ctx, SCREEN, (void *)3); }
+
+static void run_colorswap(GContext *ctx) {
+  EffectColorpair pair = { GColorWhite, GColorRed };
+  effect_colorswap(ctx, SCREEN, &pair);
+}
+
+static void run_shadow(GContext *ctx) {
+  EffectOffset shadow = { .orig_color = GColorWhite, .offset_color = GColorDarkGray, .offset_x = 2, .offset_y = 2 };
+  effect_shadow(ctx, SCREEN, &shadow);
+}
+
+// with two colors the caller keeps the pixels already drawn, a bit each with the
+// framebuffer's 20 byte rows, cleared every frame
+static void run_long_shadow(GContext *ctx) {
+  static uint8_t visited[HARNESS_SCREEN_HEIGHT * 20];
+  EffectOffset shadow = {
+    .orig_color = GColorWhite, .offset_color = GColorDarkGray, .offset_x = 2, .offset_y = 2, .option = 1,
+    .aplite_visited = visited
+  };
+  memset(visited, 0, sizeof(visited));
+  effect_shadow(ctx, SCREEN, &shadow);
+}
+
+// with two colors the outline only works when both are the same, see outline_1bit
+static void run_outline(GContext *ctx) {
+  EffectOffset outline = {
+    .orig_color = GColorWhite, .offset_color = PBL_IF_COLOR_ELSE(GColorRed, GColorWhite), .offset_x = 2, .offset_y = 2
+  };
+  effect_outline(ctx, SCREEN, &outline);
+}
+
+static void run_fill_circle(GContext *ctx) {
+  RasterTarget target;
+  if (raster_begin(&target, ctx)) {
+    raster_fill_circle(&target, GPoint(XCENTER, YCENTER), 20, GColorWhite);
+    raster_end(&target, ctx);
+  }
+}
+
+static void run_hand(GContext *ctx) {
+  RasterTarget target;
+  if (raster_begin(&target, ctx)) {
+    raster_line(&target, GPoint(XCENTER, YCENTER), GPoint(128, 15), 3, GColorWhite);
+    raster_end(&target, ctx);
+  }
+}
+
+static void run_glyph(GContext *ctx) {
+  glyph_draw(ctx, glyph, GPoint(0, 0), SCREEN, GColorWhite, false);
+}
+
+// what a GCompOpSet BitmapLayer does in its update proc
+static void run_glyph_bitmap(GContext *ctx) {
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  graphics_draw_bitmap_in_rect(ctx, glyph_bitmap, gbitmap_get_bounds(glyph_bitmap));
+}
+
+static const Kernel KERNELS[] = {
+  { "effect_invert", run_invert, 144 * 168 },
+  { "effect_invert_bw_only", run_invert_bw_only, 144 * 168 },
+  { "effect_invert_brightness", run_invert_brightness, 144 * 168, true },
+  { "effect_colorswap", run_colorswap, 144 * 168, true },
+  { "effect_mirror_vertical", run_mirror_vertical, 144 * 168 },
+  { "effect_mirror_horizontal", run_mirror_horizontal, 144 * 168 },
+  { "effect_rotate_90_degrees", run_rotate_90, 144 * 144 },
+  { "effect_zoom (hour pulse)", run_zoom, 144 * 78 },
+  { "effect_lens", run_lens, 144 * 168 },
+  { "effect_shadow", run_shadow, 144 * 168, true },
+  { "effect_shadow (long)", run_long_shadow, 144 * 168 },
+  { "effect_outline", run_outline, 144 * 168 },
+  { "effect_blur (radius 3)", run_blur, 144 * 168, true },
+  { "raster_fill_circle (r 20)", run_fill_circle, 41 * 41 },
+  { "raster_line (hand, 3px)", run_hand, 3 * 88 },
+  { "glyph_draw (time_8)", run_glyph, 0 },
+  { "graphics_draw_bitmap_in_rect (time_8, 1 bit palette)", run_glyph_bitmap, 58 * 70 },
+};
+
+// index 0 transparent and 1 white, as check_glyph_palettes in the wscript wants them
+static GBitmap *bitmap_of_glyph(const Glyph *glyph) {
+  GColor *palette = malloc(2 * sizeof(GColor));
+  if (!palette) return NULL;
+  palette[0] = GColorClear;
+  palette[1] = GColorWhite;
+  GBitmap *bitmap = gbitmap_create_blank_with_palette(glyph->size, GBitmapFormat1BitPalette, palette, true);
+  if (!bitmap) return NULL;
+  uint8_t *data = gbitmap_get_data(bitmap);
+  int bytes_per_row = gbitmap_get_bytes_per_row(bitmap);
+  for (int y = 0; y < glyph->size.h; y++) {
+    for (int i = glyph->row_start[y]; i < glyph->row_start[y + 1]; i++) {
+      for (int x = glyph->spans[i].x; x < glyph->spans[i].x + glyph->spans[i].length; x++) {
+        data[y * bytes_per_row + x / 8] |= 0x80 >> (x % 8);
+      }
+    }
+  }
+  return bitmap;
+}
+
+// a frame with something to work on: bands of colors under white shapes
+static void fill_frame(GContext *ctx) {
+  for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y += 8) {
+    graphics_context_set_fill_color(ctx, (GColor){ .argb = 0xC0 | ((y / 8 * 7) & 0x3F) });
+    graphics_fill_rect(ctx, GRect(0, y, HARNESS_SCREEN_WIDTH, 8), 0, GCornerNone);
+  }
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  graphics_fill_rect(ctx, GRect(20, 20, 50, 100), 0, GCornerNone);
+  graphics_fill_circle(ctx, GPoint(100, 110), 25);
+}
+
+static int64_t now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// nanoseconds per call, best of BATCHES batches
+static double time_kernel(const Kernel *kernel) {
+  GContext *ctx = harness_graphics_context();
+  fill_frame(ctx);
+  int64_t start = now_ns();
+  int calls = 0;
+  while (now_ns() - start < BATCH_NS / 10) {
+    kernel->run(ctx);
+    calls++;
+  }
+  int batch = MAX(1, calls * 10);
+
+  double best = 0;
+  for (int i = 0; i < BATCHES; i++) {
+    fill_frame(ctx);
+    start = now_ns();
+    for (int j = 0; j < batch; j++) kernel->run(ctx);
+    double per_call = (double)(now_ns() - start) / batch;
+    if (i == 0 || per_call < best) best = per_call;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  harness_init(0);
+  glyph = glyph_create_with_resource(RESOURCE_ID_GLYPH_TIME_8);
+  int glyph_pixels = 0;
+  for (int i = 0; glyph && i < glyph->span_count; i++) glyph_pixels += glyph->spans[i].length;
+  glyph_bitmap = glyph ? bitmap_of_glyph(glyph) : NULL;
+
+  printf("# kernel times on the host, %s framebuffer%s%s\n", PBL_IF_COLOR_ELSE("8 bit", "1 bit"),
+    argc > 1 ? ", " : "", argc > 1 ? argv[1] : "");
+  printf("\n%10s %8s  %s\n", "ns/call", "ns/px", "kernel");
+  for (int i = 0; i < (int)ARRAY_LENGTH(KERNELS); i++) {
+    const Kernel *kernel = &KERNELS[i];
+    if (kernel->color_only && !PBL_IF_COLOR_ELSE(true, false)) {
+      continue;
+    }
+    int pixels = kernel->run == run_glyph ? glyph_pixels : kernel->pixels;
+    double ns = time_kernel(kernel);
+    printf("%10.0f %8.2f  %s\n", ns, pixels ? ns / pixels : 0.0, kernel->name);
+  }
+  gbitmap_destroy(glyph_bitmap);
+  glyph_destroy(glyph);
+  return 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <pebble.h>
+
+// Drives the watchface on the host through test/pebble_shim.c. The watch's
+// clock, timers, services and storage are simulated: nothing happens until a
+// test moves time or fires an event, and after every event the window is
+// redrawn if a layer was marked dirty, like the firmware's event loop does.
+// Watchface.c is built with -Dmain=watchface_main; app_event_loop() runs the
+// function passed to harness_set_event_loop, then the app deinits.
+
+#define HARNESS_SCREEN_WIDTH 144
+#define HARNESS_SCREEN_HEIGHT 168
+
+// a resource as the SDK would ship it for the platform, see resources.py
+typedef struct HarnessResource {
+  const uint8_t *data;      // raw bytes, or bitmap rows
+  uint32_t size;
+  bool bitmap;
+  GBitmapFormat format;
+  GSize bitmap_size;
+  uint16_t bytes_per_row;
+  const uint8_t *palette;   // GColor8 argb entries of palettized bitmaps
+  uint8_t palette_size;
+} HarnessResource;
+
+extern const HarnessResource harness_resources[];
+extern const uint32_t harness_resource_count;
+
+typedef struct {
+  size_t live_bytes;
+  size_t peak_bytes;
+  uint32_t live_blocks;
+  uint32_t mallocs;
+  uint32_t frees;
+} HarnessHeap;
+
+typedef struct {
+  uint32_t frames;          // windows redrawn
+  uint32_t frame_mallocs;   // allocations made while drawing, by update procs
+  uint32_t event_mallocs;   // allocations made by handlers and timers
+} HarnessCounts;
+
+//called after every redraw, with the framebuffer already drawn
+typedef void (*HarnessFrameHandler)(void);
+
+//called for every APP_LOG line, already formatted
+typedef void (*HarnessLogHandler)(uint8_t level, const char *message);
+
+//resets the simulated watch: wall clock at time, 12h clock, connected, 100% on battery, empty storage
+void harness_init(time_t time);
+
+//run by app_event_loop() in place of the firmware's loop
+void harness_set_event_loop(void (*loop)(void));
+
+void harness_set_frame_handler(HarnessFrameHandler handler);
+
+//NULL prints errors and warnings to stderr
+void harness_set_log_handler(HarnessLogHandler handler);
+
+//after watchface_main returns: frees what the firmware frees when an app exits
+//(AppMessage buffers, pending timers), so anything still live is a leak
+void harness_app_exit(void);
+
+//sets the wall clock without a tick; timers keep their own monotonic clock
+void harness_set_time(time_t time);
+
+time_t harness_get_time(void);
+
+//moves both clocks forward, firing due timers in order and redrawing after each
+void harness_advance_ms(uint32_t ms);
+
+//calls the tick handler with the current wall clock
+void harness_tick(TimeUnits units_changed);
+
+//updates what the services report and calls their handlers if it changed
+void harness_set_battery(BatteryChargeState charge);
+void harness_set_connected(bool connected);
+
+//clock_is_24h_style() from now on, applied at the next tick like on the watch
+void harness_set_24h_style(bool is_24h);
+
+//delivers a message with one byte array tuple to the inbox handler
+void harness_receive_bytes(uint32_t key, const uint8_t *data, uint16_t length);
+
+//redraws the window now if anything is dirty; true if it did
+bool harness_render(void);
+
+//redraws the window now whether anything is dirty or not
+void harness_render_all(void);
+
+//row y of the framebuffer, harness_framebuffer_bytes_per_row() bytes
+const uint8_t *harness_framebuffer_row(int y);
+int harness_framebuffer_bytes_per_row(void);
+
+//FNV-1a over every byte of every row, the checksum the profiler logs on the watch
+uint32_t harness_framebuffer_checksum(void);
+
+//pixel of the framebuffer as GColor8 argb; on black & white 0xC0 or 0xFF
+uint8_t harness_framebuffer_pixel(int x, int y);
+
+HarnessHeap harness_heap(void);
+HarnessCounts harness_counts(void);
+
+//vibrations and timers, to check handlers did what they should
+uint32_t harness_vibe_count(void);
+uint32_t harness_pending_timers(void);
+
+//a graphics context drawing straight into the framebuffer, for tests of drawing code
+GContext *harness_graphics_context(void);
+
+//A model of the shapes the face's span rasterizer replaced, in the fill and
+//stroke colors and width of ctx: a midpoint circle, and a Bresenham line or,
+//wider, the pixels whose center is within half the width of the segment, with
+//round caps. It is what the firmware is assumed to draw without antialiasing;
+//it has never been checked against masks from the firmware or the emulator.
+//graphics_fill_circle and graphics_draw_line draw with it.
+void harness_model_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void harness_model_draw_line(GContext *ctx, GPoint p0, GPoint p1);
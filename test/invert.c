@@ -0,0 +1,90 @@
+#include <pebble.h>
+#include "harness.h"
+#include "effects.h"
+#include "settings.h"
+
+// Bluetooth fail mode draws the face with an inverted theme; before, it ran
+// effect_invert over the whole window on every redraw. This replays a day,
+// with the battery running down through every render tier, the clock style
+// switching and new colors half way, and for every frame drawn compares the
+// themed inverted frame with the normal one run through effect_invert. They
+// must be pixel-identical.
+//
+// usage: invert
+
+int watchface_main(void);
+void set_inverted(bool inverted);
+
+#define MINUTES_PER_DAY (24 * 60)
+// 2016-12-31 00:00 UTC, a two digit day and month
+#define START_TIME 1483142400
+
+static const uint8_t CONFIG[CONFIG_BYTE_COUNT] = {
+  CONFIG_PROTOCOL_VERSION, GColorRedARGB8, GColorBlueARGB8, GColorYellowARGB8, 30
+};
+
+static uint8_t expected[HARNESS_SCREEN_HEIGHT][HARNESS_SCREEN_WIDTH];
+static bool comparing;
+static uint32_t frames, failures;
+
+static void on_frame(void) {
+  if (comparing) {
+    return;
+  }
+  comparing = true;
+
+  effect_invert(harness_graphics_context(), GRect(0, 0, HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT), NULL);
+  for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < HARNESS_SCREEN_WIDTH; x++) expected[y][x] = harness_framebuffer_pixel(x, y);
+  }
+
+  set_inverted(true);
+  harness_render_all();
+  int differing = 0;
+  for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < HARNESS_SCREEN_WIDTH; x++) differing += harness_framebuffer_pixel(x, y) != expected[y][x];
+  }
+  set_inverted(false);
+  harness_render_all();
+
+  frames++;
+  if (differing) {
+    time_t now = harness_get_time();
+    char when[32];
+    strftime(when, sizeof(when), "%H:%M:%S", gmtime(&now));
+    if (++failures <= 20) printf("  frame %u at %s: %d pixels differ\n", (unsigned int)frames, when, differing);
+  }
+  comparing = false;
+}
+
+// one charge cycle: drains 10% every two hours from 100%
+static BatteryChargeState battery_at(int hour) {
+  return (BatteryChargeState){ .charge_percent = 100 - 10 * MIN(hour / 2, 10) };
+}
+
+static void run_day(void) {
+  harness_advance_ms(60 * 1000);
+  for (int minute = 0; minute < MINUTES_PER_DAY; minute++) {
+    if (minute % 60 == 0) {
+      harness_set_battery(battery_at(minute / 60));
+    }
+    if (minute == MINUTES_PER_DAY / 2) {
+      harness_set_24h_style(false);
+      harness_receive_bytes(KEY_CONFIG, CONFIG, sizeof(CONFIG));
+    }
+    harness_tick(MINUTE_UNIT);
+    harness_advance_ms(60 * 1000);
+  }
+}
+
+int main(void) {
+  harness_init(START_TIME - 60);
+  harness_set_24h_style(true);
+  harness_set_frame_handler(on_frame);
+  harness_set_event_loop(run_day);
+  watchface_main();
+  harness_app_exit();
+
+  printf("invert: %u of %u frames differ from effect_invert\n", (unsigned int)failures, (unsigned int)frames);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+// Runs src/js/pebble-js-app.js under node against a stand-in for PebbleKit JS,
+// localStorage and XMLHttpRequest: node test/js/pebble-js-app-test.js
+var assert = require('assert');
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+function createPhone() {
+  var phone = { handlers: {}, storage: {}, sent: [], opened: [], requests: [], log: [], status: 200 };
+
+  function XMLHttpRequest() {
+    this.headers = {};
+  }
+  XMLHttpRequest.prototype.open = function(method, url) {
+    this.method = method;
+    this.url = url;
+  };
+  XMLHttpRequest.prototype.setRequestHeader = function(name, value) {
+    this.headers[name] = value;
+  };
+  XMLHttpRequest.prototype.send = function(body) {
+    this.body = body;
+    phone.requests.push(this);
+  };
+  // answers the oldest pending request
+  phone.respond = function(status) {
+    var request = phone.requests.shift();
+    request.status = status;
+    if (status) {
+      request.onload();
+    } else {
+      request.onerror();
+    }
+    return request;
+  };
+
+  phone.context = vm.createContext({
+    console: { log: function(line) { phone.log.push(line); } },
+    localStorage: {
+      getItem: function(key) { return key in phone.storage ? phone.storage[key] : null; },
+      setItem: function(key, value) { phone.storage[key] = String(value); }
+    },
+    XMLHttpRequest: XMLHttpRequest,
+    Pebble: {
+      addEventListener: function(name, handler) { phone.handlers[name] = handler; },
+      getActiveWatchInfo: function() { return { platform: 'basalt' }; },
+      openURL: function(url) { phone.opened.push(url); },
+      sendAppMessage: function(dict, success, failure) {
+        phone.sent.push(dict);
+        if (phone.sendFails) failure(); else success();
+      }
+    },
+    // stands in for the generated src/js/config_page.js
+    CONFIG_PAGE_HTML: '<script>var watchSettings = /*WATCH_SETTINGS*/null;</script>'
+  });
+  var script = path.join(__dirname, '..', '..', 'src', 'js', 'pebble-js-app.js');
+  vm.runInContext(fs.readFileSync(script, 'utf8'), phone.context, { filename: script });
+  return phone;
+}
+
+// a TelemetryPayload as the watch packs it
+function telemetryPayload(frames, heapPeak) {
+  var bytes = [1, 15, 0, frames & 0xFF, frames >> 8];
+  [12, 40, 2, 8, 9, 15, 20, 90].forEach(function(value) { bytes.push(value & 0xFF, value >> 8); });
+  [heapPeak, 5000].forEach(function(value) {
+    bytes.push(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >>> 24);
+  });
+  return bytes;
+}
+
+function configResponse(settings) {
+  return { response: encodeURIComponent(JSON.stringify(settings)) };
+}
+
+var SETTINGS = {
+  minute_hand_color: '#555500', hour_hand_color: '#5555AA', digit_color: '#FFFFFF',
+  power_saver_percent: '20', telemetry_url: 'https://example.com/telemetry'
+};
+
+var tests = {
+  'decodes a telemetry payload': function() {
+    var phone = createPhone();
+    var sample = phone.context.decodeTelemetry(telemetryPayload(30, 70000));
+    assert.strictEqual(sample.frames, 30);
+    assert.strictEqual(sample.frameMsAvg, 12);
+    assert.strictEqual(sample.tickMsMax, 90);
+    assert.strictEqual(sample.heapPeak, 70000);
+    assert.strictEqual(sample.heapUsed, 5000);
+    assert.strictEqual(phone.context.decodeTelemetry([1, 2, 3]), null);
+  },
+
+  'keeps a week of samples': function() {
+    var phone = createPhone();
+    for (var i = 0; i < phone.context.TELEMETRY_MAX_SAMPLES + 5; i++) {
+      phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(i, 1000) } });
+    }
+    var samples = phone.context.loadTelemetry();
+    assert.strictEqual(samples.length, phone.context.TELEMETRY_MAX_SAMPLES);
+    assert.strictEqual(samples[0].frames, 5);
+    assert.strictEqual(samples[0].platform, 'basalt');
+  },
+
+  'summarizes with averages weighted by counts': function() {
+    var phone = createPhone();
+    var summary = phone.context.summarizeTelemetry([
+      { minutes: 15, frames: 10, frameMsAvg: 10, frameMsMax: 30, effectRuns: 0, effectMsAvg: 0, effectMsMax: 0,
+        ticks: 15, tickMsAvg: 20, tickMsMax: 40, heapPeak: 100 },
+      { minutes: 15, frames: 30, frameMsAvg: 30, frameMsMax: 50, effectRuns: 0, effectMsAvg: 0, effectMsMax: 0,
+        ticks: 15, tickMsAvg: 40, tickMsMax: 60, heapPeak: 300 }
+    ]);
+    assert.strictEqual(summary.frames, 40);
+    assert.strictEqual(summary.frameMsAvg, 25);
+    assert.strictEqual(summary.frameMsMax, 50);
+    assert.strictEqual(summary.tickMsAvg, 30);
+    assert.strictEqual(summary.heapPeak, 300);
+  },
+
+  'keeps telemetry on the phone without an address': function() {
+    var phone = createPhone();
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(30, 1000) } });
+    assert.strictEqual(phone.requests.length, 0);
+  },
+
+  'posts samples not exported yet as CSV': function() {
+    var phone = createPhone();
+    phone.handlers.webviewclosed(configResponse(SETTINGS));
+    assert.strictEqual(phone.requests.length, 0);  // nothing stored yet
+
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(30, 1000) } });
+    var request = phone.respond(200);
+    assert.strictEqual(request.method, 'POST');
+    assert.strictEqual(request.url, SETTINGS.telemetry_url);
+    assert.strictEqual(request.headers['Content-Type'], 'text/csv');
+    var rows = request.body.split('\n');
+    assert.strictEqual(rows[0], phone.context.TELEMETRY_FIELDS.join(','));
+    assert.strictEqual(rows.length, 2);
+    assert.strictEqual(rows[1].split(',')[phone.context.TELEMETRY_FIELDS.indexOf('frames')], '30');
+
+    // only the new sample goes out with the next one
+    phone.storage.telemetry = phone.storage.telemetry.replace(/"received":"[^"]*"/, '"received":"2016-01-01T00:00:00.000Z"');
+    phone.storage.telemetryExported = '2016-01-01T00:00:00.000Z';
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(31, 1000) } });
+    rows = phone.respond(200).body.split('\n');
+    assert.strictEqual(rows.length, 2);
+    assert.strictEqual(rows[1].split(',')[phone.context.TELEMETRY_FIELDS.indexOf('frames')], '31');
+  },
+
+  'retries a failed export with the next sample': function() {
+    var phone = createPhone();
+    phone.handlers.webviewclosed(configResponse(SETTINGS));
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(30, 1000) } });
+    phone.respond(500);
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(31, 1000) } });
+    phone.respond(0);
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(32, 1000) } });
+    assert.strictEqual(phone.respond(200).body.split('\n').length, 4);
+  },
+
+  'exports what is stored once an address is saved': function() {
+    var phone = createPhone();
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(30, 1000) } });
+    phone.handlers.appmessage({ payload: { KEY_TELEMETRY: telemetryPayload(31, 1000) } });
+    phone.handlers.webviewclosed(configResponse(SETTINGS));
+    assert.strictEqual(phone.respond(200).body.split('\n').length, 3);
+  },
+
+  'sends settings as one config byte array': function() {
+    var phone = createPhone();
+    phone.handlers.webviewclosed(configResponse(SETTINGS));
+    assert.deepStrictEqual(Array.from(phone.sent[0].KEY_CONFIG), [1, 0xD4, 0xD6, 0xFF, 20]);
+    phone.handlers.webviewclosed({ response: '' });
+    assert.strictEqual(phone.sent.length, 1);
+  },
+
+  'opens the settings page with what the watch has': function() {
+    var phone = createPhone();
+    phone.handlers.webviewclosed(configResponse(SETTINGS));
+    phone.handlers.showConfiguration();
+    var html = decodeURIComponent(phone.opened[0].replace('data:text/html;charset=utf-8,', ''));
+    assert.ok(html.indexOf(JSON.stringify(SETTINGS)) >= 0);
+
+    var failing = createPhone();
+    failing.sendFails = true;
+    failing.handlers.webviewclosed(configResponse(SETTINGS));
+    failing.handlers.showConfiguration();
+    assert.ok(decodeURIComponent(failing.opened[0]).indexOf('watchSettings = null') >= 0);
+  },
+
+  'keeps stored strings inside the settings page script': function() {
+    var settings = JSON.parse(JSON.stringify(SETTINGS));
+    settings.telemetry_url = 'https://example.com/</script><script>alert(1)</script><!-- $\' $& \u2028\u2029';
+    var phone = createPhone();
+    phone.handlers.webviewclosed(configResponse(settings));
+    phone.handlers.showConfiguration();
+    var html = decodeURIComponent(phone.opened[0].replace('data:text/html;charset=utf-8,', ''));
+    assert.strictEqual(html.split('</script>').length, 2);
+    assert.strictEqual(html.indexOf('<!--'), -1);
+    var page = vm.createContext({});
+    vm.runInContext(html.replace(/^<script>/, '').replace(/<\/script>$/, ''), page);
+    assert.strictEqual(JSON.stringify(page.watchSettings), JSON.stringify(settings));
+  }
+};
+
+var failures = 0;
+Object.keys(tests).forEach(function(name) {
+  try {
+    tests[name]();
+    console.log('ok   ' + name);
+  } catch (e) {
+    ++failures;
+    console.log('FAIL ' + name + '\n' + e.stack);
+  }
+});
+process.exit(failures ? 1 : 0);
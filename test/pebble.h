@@ -0,0 +1,512 @@
+#pragma once
+
+// Host stand-in for the parts of the Pebble SDK 3 API the watchface uses, so
+// src/ builds and runs on a PC under the harness in this directory. Types,
+// constants and colors match the SDK; test/pebble_shim.c implements the
+// functions on a plain framebuffer with a simulated clock. The platform comes
+// from the same defines the SDK passes: PBL_PLATFORM_BASALT PBL_COLOR PBL_RECT
+// or PBL_PLATFORM_APLITE PBL_BW PBL_RECT. Round displays aren't simulated.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "resource_ids.auto.h"
+
+#if !defined(PBL_COLOR) && !defined(PBL_BW)
+#error "define PBL_COLOR or PBL_BW, as the SDK does for each platform"
+#endif
+
+// Heap
+
+// every app allocation goes through the harness, which counts them
+void *harness_malloc(size_t size);
+void harness_free(void *ptr);
+#define malloc(size) harness_malloc(size)
+#define free(ptr) harness_free(ptr)
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+// Platform
+
+#ifdef PBL_COLOR
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#define COLOR_FALLBACK(color, bw) (color)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#define COLOR_FALLBACK(color, bw) (bw)
+#endif
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// Geometry
+
+typedef struct { int16_t x, y; } GPoint;
+typedef struct { int16_t w, h; } GSize;
+typedef struct { GPoint origin; GSize size; } GRect;
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+#define GPointZero GPoint(0, 0)
+#define GRectZero GRect(0, 0, 0, 0)
+
+bool gpoint_equal(const GPoint *point_a, const GPoint *point_b);
+bool gsize_equal(const GSize *size_a, const GSize *size_b);
+bool grect_equal(const GRect *rect_a, const GRect *rect_b);
+bool grect_contains_point(const GRect *rect, const GPoint *point);
+void grect_clip(GRect *rect_to_clip, const GRect *rect_clipper);
+
+// Colors, 2 bits per channel
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b:2;
+    uint8_t g:2;
+    uint8_t r:2;
+    uint8_t a:2;
+  };
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorARGB8(argb_value) ((GColor8){ .argb = (argb_value) })
+
+GColor8 GColorFromRGB(uint8_t red, uint8_t green, uint8_t blue);
+GColor8 GColorFromRGBA(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha);
+GColor8 GColorFromHEX(uint32_t hex);
+bool gcolor_equal(GColor8 color_a, GColor8 color_b);
+
+#define GColorBlackARGB8 0xC0
+#define GColorOxfordBlueARGB8 0xC1
+#define GColorDukeBlueARGB8 0xC2
+#define GColorBlueARGB8 0xC3
+#define GColorDarkGreenARGB8 0xC4
+#define GColorMidnightGreenARGB8 0xC5
+#define GColorCobaltBlueARGB8 0xC6
+#define GColorBlueMoonARGB8 0xC7
+#define GColorIslamicGreenARGB8 0xC8
+#define GColorJaegerGreenARGB8 0xC9
+#define GColorTiffanyBlueARGB8 0xCA
+#define GColorVividCeruleanARGB8 0xCB
+#define GColorGreenARGB8 0xCC
+#define GColorMalachiteARGB8 0xCD
+#define GColorMediumSpringGreenARGB8 0xCE
+#define GColorCyanARGB8 0xCF
+#define GColorBulgarianRoseARGB8 0xD0
+#define GColorImperialPurpleARGB8 0xD1
+#define GColorIndigoARGB8 0xD2
+#define GColorElectricUltramarineARGB8 0xD3
+#define GColorArmyGreenARGB8 0xD4
+#define GColorDarkGrayARGB8 0xD5
+#define GColorLibertyARGB8 0xD6
+#define GColorVeryLightBlueARGB8 0xD7
+#define GColorKellyGreenARGB8 0xD8
+#define GColorMayGreenARGB8 0xD9
+#define GColorCadetBlueARGB8 0xDA
+#define GColorPictonBlueARGB8 0xDB
+#define GColorBrightGreenARGB8 0xDC
+#define GColorScreaminGreenARGB8 0xDD
+#define GColorMediumAquamarineARGB8 0xDE
+#define GColorElectricBlueARGB8 0xDF
+#define GColorDarkCandyAppleRedARGB8 0xE0
+#define GColorJazzberryJamARGB8 0xE1
+#define GColorPurpleARGB8 0xE2
+#define GColorVividVioletARGB8 0xE3
+#define GColorWindsorTanARGB8 0xE4
+#define GColorRoseValeARGB8 0xE5
+#define GColorPurpureusARGB8 0xE6
+#define GColorLavenderIndigoARGB8 0xE7
+#define GColorLimerickARGB8 0xE8
+#define GColorBrassARGB8 0xE9
+#define GColorLightGrayARGB8 0xEA
+#define GColorBabyBlueEyesARGB8 0xEB
+#define GColorSpringBudARGB8 0xEC
+#define GColorInchwormARGB8 0xED
+#define GColorMintGreenARGB8 0xEE
+#define GColorCelesteARGB8 0xEF
+#define GColorRedARGB8 0xF0
+#define GColorFollyARGB8 0xF1
+#define GColorFashionMagentaARGB8 0xF2
+#define GColorMagentaARGB8 0xF3
+#define GColorOrangeARGB8 0xF4
+#define GColorSunsetOrangeARGB8 0xF5
+#define GColorBrilliantRoseARGB8 0xF6
+#define GColorShockingPinkARGB8 0xF7
+#define GColorChromeYellowARGB8 0xF8
+#define GColorRajahARGB8 0xF9
+#define GColorMelonARGB8 0xFA
+#define GColorRichBrilliantLavenderARGB8 0xFB
+#define GColorYellowARGB8 0xFC
+#define GColorIcterineARGB8 0xFD
+#define GColorPastelYellowARGB8 0xFE
+#define GColorWhiteARGB8 0xFF
+#define GColorClearARGB8 0x00
+
+#define GColorBlack GColorARGB8(GColorBlackARGB8)
+#define GColorOxfordBlue GColorARGB8(GColorOxfordBlueARGB8)
+#define GColorDukeBlue GColorARGB8(GColorDukeBlueARGB8)
+#define GColorBlue GColorARGB8(GColorBlueARGB8)
+#define GColorDarkGreen GColorARGB8(GColorDarkGreenARGB8)
+#define GColorMidnightGreen GColorARGB8(GColorMidnightGreenARGB8)
+#define GColorCobaltBlue GColorARGB8(GColorCobaltBlueARGB8)
+#define GColorBlueMoon GColorARGB8(GColorBlueMoonARGB8)
+#define GColorIslamicGreen GColorARGB8(GColorIslamicGreenARGB8)
+#define GColorJaegerGreen GColorARGB8(GColorJaegerGreenARGB8)
+#define GColorTiffanyBlue GColorARGB8(GColorTiffanyBlueARGB8)
+#define GColorVividCerulean GColorARGB8(GColorVividCeruleanARGB8)
+#define GColorGreen GColorARGB8(GColorGreenARGB8)
+#define GColorMalachite GColorARGB8(GColorMalachiteARGB8)
+#define GColorMediumSpringGreen GColorARGB8(GColorMediumSpringGreenARGB8)
+#define GColorCyan GColorARGB8(GColorCyanARGB8)
+#define GColorBulgarianRose GColorARGB8(GColorBulgarianRoseARGB8)
+#define GColorImperialPurple GColorARGB8(GColorImperialPurpleARGB8)
+#define GColorIndigo GColorARGB8(GColorIndigoARGB8)
+#define GColorElectricUltramarine GColorARGB8(GColorElectricUltramarineARGB8)
+#define GColorArmyGreen GColorARGB8(GColorArmyGreenARGB8)
+#define GColorDarkGray GColorARGB8(GColorDarkGrayARGB8)
+#define GColorLiberty GColorARGB8(GColorLibertyARGB8)
+#define GColorVeryLightBlue GColorARGB8(GColorVeryLightBlueARGB8)
+#define GColorKellyGreen GColorARGB8(GColorKellyGreenARGB8)
+#define GColorMayGreen GColorARGB8(GColorMayGreenARGB8)
+#define GColorCadetBlue GColorARGB8(GColorCadetBlueARGB8)
+#define GColorPictonBlue GColorARGB8(GColorPictonBlueARGB8)
+#define GColorBrightGreen GColorARGB8(GColorBrightGreenARGB8)
+#define GColorScreaminGreen GColorARGB8(GColorScreaminGreenARGB8)
+#define GColorMediumAquamarine GColorARGB8(GColorMediumAquamarineARGB8)
+#define GColorElectricBlue GColorARGB8(GColorElectricBlueARGB8)
+#define GColorDarkCandyAppleRed GColorARGB8(GColorDarkCandyAppleRedARGB8)
+#define GColorJazzberryJam GColorARGB8(GColorJazzberryJamARGB8)
+#define GColorPurple GColorARGB8(GColorPurpleARGB8)
+#define GColorVividViolet GColorARGB8(GColorVividVioletARGB8)
+#define GColorWindsorTan GColorARGB8(GColorWindsorTanARGB8)
+#define GColorRoseVale GColorARGB8(GColorRoseValeARGB8)
+#define GColorPurpureus GColorARGB8(GColorPurpureusARGB8)
+#define GColorLavenderIndigo GColorARGB8(GColorLavenderIndigoARGB8)
+#define GColorLimerick GColorARGB8(GColorLimerickARGB8)
+#define GColorBrass GColorARGB8(GColorBrassARGB8)
+#define GColorLightGray GColorARGB8(GColorLightGrayARGB8)
+#define GColorBabyBlueEyes GColorARGB8(GColorBabyBlueEyesARGB8)
+#define GColorSpringBud GColorARGB8(GColorSpringBudARGB8)
+#define GColorInchworm GColorARGB8(GColorInchwormARGB8)
+#define GColorMintGreen GColorARGB8(GColorMintGreenARGB8)
+#define GColorCeleste GColorARGB8(GColorCelesteARGB8)
+#define GColorRed GColorARGB8(GColorRedARGB8)
+#define GColorFolly GColorARGB8(GColorFollyARGB8)
+#define GColorFashionMagenta GColorARGB8(GColorFashionMagentaARGB8)
+#define GColorMagenta GColorARGB8(GColorMagentaARGB8)
+#define GColorOrange GColorARGB8(GColorOrangeARGB8)
+#define GColorSunsetOrange GColorARGB8(GColorSunsetOrangeARGB8)
+#define GColorBrilliantRose GColorARGB8(GColorBrilliantRoseARGB8)
+#define GColorShockingPink GColorARGB8(GColorShockingPinkARGB8)
+#define GColorChromeYellow GColorARGB8(GColorChromeYellowARGB8)
+#define GColorRajah GColorARGB8(GColorRajahARGB8)
+#define GColorMelon GColorARGB8(GColorMelonARGB8)
+#define GColorRichBrilliantLavender GColorARGB8(GColorRichBrilliantLavenderARGB8)
+#define GColorYellow GColorARGB8(GColorYellowARGB8)
+#define GColorIcterine GColorARGB8(GColorIcterineARGB8)
+#define GColorPastelYellow GColorARGB8(GColorPastelYellowARGB8)
+#define GColorWhite GColorARGB8(GColorWhiteARGB8)
+#define GColorClear GColorARGB8(GColorClearARGB8)
+
+// Bitmaps
+
+typedef enum {
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette, bool free_on_destroy);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GColor *gbitmap_get_palette(const GBitmap *bitmap);
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy);
+
+// Graphics
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet,
+} GCompOp;
+
+typedef enum {
+  GCornerNone = 0,
+  GCornerTopLeft = 1 << 0,
+  GCornerTopRight = 1 << 1,
+  GCornerBottomLeft = 1 << 2,
+  GCornerBottomRight = 1 << 3,
+  GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight,
+} GCornerMask;
+
+typedef enum { GTextOverflowModeWordWrap, GTextOverflowModeTrailingEllipsis, GTextOverflowModeFill } GTextOverflowMode;
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+typedef enum {
+  GAlignCenter, GAlignTopLeft, GAlignTopRight, GAlignTop, GAlignLeft,
+  GAlignBottom, GAlignRight, GAlignBottomRight, GAlignBottomLeft,
+} GAlign;
+
+typedef struct GContext GContext;
+typedef struct FontInfo *GFont;
+typedef struct GTextAttributes GTextAttributes;
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+GFont fonts_get_system_font(const char *font_key);
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+//text isn't rasterized on the host, nothing the face shows is text
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment, GTextAttributes *text_attributes);
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+GBitmap *graphics_capture_frame_buffer_format(GContext *ctx, GBitmapFormat format);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// Layers and windows
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct BitmapLayer BitmapLayer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_bounds(Layer *layer, GRect bounds);
+void layer_set_clips(Layer *layer, bool clips);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+Window *layer_get_window(const Layer *layer);
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap);
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment);
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color);
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode);
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_stack_push(Window *window, bool animated);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor background_color);
+
+// Events and services
+
+void app_event_loop(void);
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3,
+  MONTH_UNIT = 1 << 4,
+  YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef struct {
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+
+typedef void (*BluetoothConnectionHandler)(bool connected);
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler);
+void bluetooth_connection_service_unsubscribe(void);
+bool bluetooth_connection_service_peek(void);
+
+bool clock_is_24h_style(void);
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+void vibes_double_pulse(void);
+
+// Math
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+// Logging
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+  __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ## __VA_ARGS__)
+
+// Storage
+
+typedef int32_t status_t;
+typedef enum {
+  S_SUCCESS = 0,
+  E_ERROR = -1,
+  E_UNKNOWN = -2,
+  E_INTERNAL = -3,
+  E_INVALID_ARGUMENT = -4,
+  E_OUT_OF_MEMORY = -5,
+  E_OUT_OF_STORAGE = -6,
+  E_OUT_OF_RESOURCES = -7,
+  E_RANGE = -8,
+  E_DOES_NOT_EXIST = -9,
+  E_INVALID_OPERATION = -10,
+  E_BUSY = -11,
+  S_TRUE = 1,
+  S_FALSE = 0,
+  S_NO_MORE_ITEMS = 2,
+  S_NO_ACTION_REQUIRED = 3,
+} StatusCode;
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// Dictionaries and AppMessage
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2,
+  DICT_INTERNAL_INCONSISTENCY = 1 << 3,
+  DICT_MALLOC_FAILED = 1 << 4,
+} DictionaryResult;
+
+typedef struct DictionaryIterator DictionaryIterator;
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size);
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 2,
+  APP_MSG_SEND_REJECTED = 4,
+  APP_MSG_NOT_CONNECTED = 8,
+  APP_MSG_APP_NOT_RUNNING = 16,
+  APP_MSG_INVALID_ARGS = 32,
+  APP_MSG_BUSY = 64,
+  APP_MSG_BUFFER_OVERFLOW = 128,
+  APP_MSG_ALREADY_RELEASED = 512,
+  APP_MSG_CALLBACK_ALREADY_REGISTERED = 1024,
+  APP_MSG_CALLBACK_NOT_REGISTERED = 2048,
+  APP_MSG_OUT_OF_MEMORY = 4096,
+  APP_MSG_CLOSED = 8192,
+  APP_MSG_INTERNAL_ERROR = 16384,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+
+// Resources
+
+typedef const struct HarnessResource *ResHandle;
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle handle);
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length);
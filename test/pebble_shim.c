@@ -0,0 +1,1473 @@
+#include <pebble.h>
+#include <math.h>
+#include <stdarg.h>
+#include "harness.h"
+
+// the shim's own bookkeeping uses the C library heap, SDK objects the app heap
+#undef malloc
+#undef free
+
+// app heap left to the app after its code, roughly
+#define HEAP_SIZE PBL_IF_COLOR_ELSE(65536, 24576)
+
+#define MAX_TIMERS 32
+#define MAX_PERSIST_KEYS 64
+#define LOG_LINE_LENGTH 256
+
+#define FRAMEBUFFER_FORMAT PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit)
+#define FRAMEBUFFER_BYTES_PER_ROW PBL_IF_COLOR_ELSE(HARNESS_SCREEN_WIDTH, 20)
+
+// Heap
+
+// keeps the alignment malloc gives
+typedef struct {
+  size_t size;
+  size_t reserved;
+} BlockHeader;
+
+static HarnessHeap heap;
+static HarnessCounts counts;
+static bool drawing;
+
+void *harness_malloc(size_t size) {
+  BlockHeader *block = malloc(sizeof(BlockHeader) + size);
+  if (!block) {
+    return NULL;
+  }
+  block->size = size;
+  heap.live_bytes += size;
+  heap.peak_bytes = MAX(heap.peak_bytes, heap.live_bytes);
+  heap.live_blocks++;
+  heap.mallocs++;
+  if (drawing) {
+    counts.frame_mallocs++;
+  } else {
+    counts.event_mallocs++;
+  }
+  return block + 1;
+}
+
+void harness_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  BlockHeader *block = (BlockHeader *)ptr - 1;
+  heap.live_bytes -= block->size;
+  heap.live_blocks--;
+  heap.frees++;
+  free(block);
+}
+
+size_t heap_bytes_used(void) {
+  return heap.live_bytes;
+}
+
+size_t heap_bytes_free(void) {
+  return heap.live_bytes < HEAP_SIZE ? HEAP_SIZE - heap.live_bytes : 0;
+}
+
+HarnessHeap harness_heap(void) {
+  return heap;
+}
+
+HarnessCounts harness_counts(void) {
+  return counts;
+}
+
+// Geometry
+
+bool gpoint_equal(const GPoint *point_a, const GPoint *point_b) {
+  return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool gsize_equal(const GSize *size_a, const GSize *size_b) {
+  return size_a->w == size_b->w && size_a->h == size_b->h;
+}
+
+bool grect_equal(const GRect *rect_a, const GRect *rect_b) {
+  return gpoint_equal(&rect_a->origin, &rect_b->origin) && gsize_equal(&rect_a->size, &rect_b->size);
+}
+
+bool grect_contains_point(const GRect *rect, const GPoint *point) {
+  return point->x >= rect->origin.x && point->x < rect->origin.x + rect->size.w &&
+         point->y >= rect->origin.y && point->y < rect->origin.y + rect->size.h;
+}
+
+void grect_clip(GRect *rect_to_clip, const GRect *rect_clipper) {
+  int x0 = MAX(rect_to_clip->origin.x, rect_clipper->origin.x);
+  int y0 = MAX(rect_to_clip->origin.y, rect_clipper->origin.y);
+  int x1 = MIN(rect_to_clip->origin.x + rect_to_clip->size.w, rect_clipper->origin.x + rect_clipper->size.w);
+  int y1 = MIN(rect_to_clip->origin.y + rect_to_clip->size.h, rect_clipper->origin.y + rect_clipper->size.h);
+  *rect_to_clip = GRect(x0, y0, MAX(x1 - x0, 0), MAX(y1 - y0, 0));
+}
+
+static GRect grect_offset(GRect rect, GPoint offset) {
+  rect.origin.x += offset.x;
+  rect.origin.y += offset.y;
+  return rect;
+}
+
+// Colors
+
+GColor8 GColorFromRGBA(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+  return (GColor8){ .a = alpha >> 6, .r = red >> 6, .g = green >> 6, .b = blue >> 6 };
+}
+
+GColor8 GColorFromRGB(uint8_t red, uint8_t green, uint8_t blue) {
+  return GColorFromRGBA(red, green, blue, 255);
+}
+
+GColor8 GColorFromHEX(uint32_t hex) {
+  return GColorFromRGB(hex >> 16, hex >> 8, hex);
+}
+
+bool gcolor_equal(GColor8 color_a, GColor8 color_b) {
+  return color_a.argb == color_b.argb || (color_a.a == 0 && color_b.a == 0);
+}
+
+// black & white displays round colors the way raster_is_light does
+static bool is_light(uint8_t argb) {
+  return ((argb >> 4) & 3) + ((argb >> 2) & 3) + (argb & 3) >= 5;
+}
+
+// Bitmaps
+
+struct GBitmap {
+  uint8_t *addr;
+  uint16_t row_size_bytes;
+  GBitmapFormat format;
+  GRect bounds;
+  GColor *palette;
+  bool free_data;
+  bool free_palette;
+};
+
+static uint16_t format_row_size(GBitmapFormat format, int width) {
+  switch (format) {
+    case GBitmapFormat1Bit: return (width + 31) / 32 * 4;  // rows are word aligned
+    case GBitmapFormat1BitPalette: return (width + 7) / 8;
+    case GBitmapFormat2BitPalette: return (width + 3) / 4;
+    case GBitmapFormat4BitPalette: return (width + 1) / 2;
+    default: return width;
+  }
+}
+
+static int format_palette_size(GBitmapFormat format) {
+  switch (format) {
+    case GBitmapFormat1BitPalette: return 2;
+    case GBitmapFormat2BitPalette: return 4;
+    case GBitmapFormat4BitPalette: return 16;
+    default: return 0;
+  }
+}
+
+static GBitmap *bitmap_create(GSize size, GBitmapFormat format, uint16_t row_size_bytes) {
+  GBitmap *bitmap = harness_malloc(sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  memset(bitmap, 0, sizeof(GBitmap));
+  bitmap->row_size_bytes = row_size_bytes;
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->addr = harness_malloc(row_size_bytes * size.h);
+  bitmap->free_data = true;
+  if (!bitmap->addr) {
+    harness_free(bitmap);
+    return NULL;
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap = bitmap_create(size, format, format_row_size(format, size.w));
+  if (!bitmap) {
+    return NULL;
+  }
+  memset(bitmap->addr, 0, bitmap->row_size_bytes * size.h);
+  int palette_size = format_palette_size(format);
+  if (palette_size) {
+    bitmap->palette = harness_malloc(palette_size * sizeof(GColor));
+    memset(bitmap->palette, 0, palette_size * sizeof(GColor));
+    bitmap->free_palette = true;
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette, bool free_on_destroy) {
+  GBitmap *bitmap = bitmap_create(size, format, format_row_size(format, size.w));
+  if (!bitmap) {
+    return NULL;
+  }
+  memset(bitmap->addr, 0, bitmap->row_size_bytes * size.h);
+  bitmap->palette = palette;
+  bitmap->free_palette = free_on_destroy;
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  ResHandle resource = resource_get_handle(resource_id);
+  if (!resource || !resource->bitmap) {
+    return NULL;
+  }
+  GBitmap *bitmap = bitmap_create(resource->bitmap_size, resource->format, resource->bytes_per_row);
+  if (!bitmap) {
+    return NULL;
+  }
+  memcpy(bitmap->addr, resource->data, resource->size);
+  if (resource->palette_size) {
+    bitmap->palette = harness_malloc(resource->palette_size * sizeof(GColor));
+    memcpy(bitmap->palette, resource->palette, resource->palette_size);
+    bitmap->free_palette = true;
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+  GBitmap *bitmap = harness_malloc(sizeof(GBitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+  *bitmap = *base_bitmap;
+  bitmap->bounds = grect_offset(sub_rect, base_bitmap->bounds.origin);
+  grect_clip(&bitmap->bounds, &base_bitmap->bounds);
+  bitmap->free_data = false;
+  bitmap->free_palette = false;
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (!bitmap) {
+    return;
+  }
+  if (bitmap->free_palette) harness_free(bitmap->palette);
+  if (bitmap->free_data) harness_free(bitmap->addr);
+  harness_free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->addr;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->row_size_bytes;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap) {
+  return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy) {
+  if (bitmap->free_palette && bitmap->palette != palette) {
+    harness_free(bitmap->palette);
+  }
+  bitmap->palette = palette;
+  bitmap->free_palette = free_on_destroy;
+}
+
+// pixel x, y of the bitmap's data as GColor8 argb, 1 bit pixels black or white
+static uint8_t bitmap_pixel(const GBitmap *bitmap, int x, int y) {
+  const uint8_t *row = bitmap->addr + y * bitmap->row_size_bytes;
+  switch (bitmap->format) {
+    case GBitmapFormat1Bit:
+      return (row[x / 8] >> (x % 8)) & 1 ? GColorWhiteARGB8 : GColorBlackARGB8;
+    case GBitmapFormat1BitPalette:
+      return bitmap->palette[(row[x / 8] >> (7 - x % 8)) & 0x1].argb;
+    case GBitmapFormat2BitPalette:
+      return bitmap->palette[(row[x / 4] >> (6 - 2 * (x % 4))) & 0x3].argb;
+    case GBitmapFormat4BitPalette:
+      return bitmap->palette[(row[x / 2] >> (4 - 4 * (x % 2))) & 0xF].argb;
+    default:
+      return row[x];
+  }
+}
+
+// Framebuffer
+
+static uint8_t framebuffer_data[FRAMEBUFFER_BYTES_PER_ROW * HARNESS_SCREEN_HEIGHT];
+static GBitmap framebuffer = {
+  .addr = framebuffer_data,
+  .row_size_bytes = FRAMEBUFFER_BYTES_PER_ROW,
+  .format = FRAMEBUFFER_FORMAT,
+  .bounds = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT } },
+};
+static const GRect SCREEN = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT } };
+
+uint8_t harness_framebuffer_pixel(int x, int y) {
+  return bitmap_pixel(&framebuffer, x, y);
+}
+
+const uint8_t *harness_framebuffer_row(int y) {
+  return framebuffer_data + y * FRAMEBUFFER_BYTES_PER_ROW;
+}
+
+int harness_framebuffer_bytes_per_row(void) {
+  return FRAMEBUFFER_BYTES_PER_ROW;
+}
+
+uint32_t harness_framebuffer_checksum(void) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(framebuffer_data); i++) {
+    hash = (hash ^ framebuffer_data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+#ifdef PBL_COLOR
+// GCompOpSet blends by the source alpha, every other mode copies the pixel
+static void framebuffer_put(int x, int y, uint8_t argb, GCompOp mode) {
+  uint8_t *pixel = &framebuffer_data[y * FRAMEBUFFER_BYTES_PER_ROW + x];
+  int alpha = argb >> 6;
+  if (mode != GCompOpSet || alpha == 3) {
+    *pixel = argb;
+    return;
+  }
+  if (alpha == 0) {
+    return;
+  }
+  uint8_t blended = 0xC0;
+  for (int shift = 0; shift < 6; shift += 2) {
+    int src = (argb >> shift) & 3, dst = (*pixel >> shift) & 3;
+    blended |= ((src * alpha + dst * (3 - alpha)) / 3) << shift;
+  }
+  *pixel = blended;
+}
+#else
+// 1 bit modes combine the source bit with the one on screen
+static void framebuffer_put(int x, int y, uint8_t argb, GCompOp mode) {
+  uint8_t *byte = &framebuffer_data[y * FRAMEBUFFER_BYTES_PER_ROW + x / 8];
+  uint8_t bit = 1 << (x % 8);
+  bool src = (argb >> 6) && is_light(argb);
+  bool dst = *byte & bit;
+  bool out;
+  switch (mode) {
+    case GCompOpAssignInverted: out = !src; break;
+    case GCompOpOr: out = dst || src; break;
+    case GCompOpAnd: out = dst && src; break;
+    case GCompOpClear: out = dst && !src; break;
+    case GCompOpSet: out = dst || !src; break;
+    default: out = src; break;
+  }
+  *byte = out ? *byte | bit : *byte & ~bit;
+}
+#endif
+
+// x0 to x1 of row y in one color, as fills draw it
+static void framebuffer_fill_span(int y, int x0, int x1, uint8_t argb) {
+  if (x0 >= x1) {
+    return;
+  }
+#ifdef PBL_COLOR
+  if (argb >> 6 == 3) {
+    memset(&framebuffer_data[y * FRAMEBUFFER_BYTES_PER_ROW + x0], argb, x1 - x0);
+    return;
+  }
+  for (int x = x0; x < x1; x++) {
+    framebuffer_put(x, y, argb, GCompOpSet);
+  }
+#else
+  uint8_t *row = &framebuffer_data[y * FRAMEBUFFER_BYTES_PER_ROW];
+  bool white = is_light(argb);
+  for (int x = x0; x < x1; x++) {
+    if (x % 8 == 0 && x1 - x >= 8) {
+      int bytes = (x1 - x) / 8;
+      memset(&row[x / 8], white ? 0xFF : 0x00, bytes);
+      x += 8 * bytes - 1;
+    } else if (white) {
+      row[x / 8] |= 1 << (x % 8);
+    } else {
+      row[x / 8] &= ~(1 << (x % 8));
+    }
+  }
+#endif
+}
+
+// Graphics
+
+typedef struct {
+  GRect drawing_box;  // layer bounds on screen
+  GRect clip_box;
+  GColor fill_color;
+  GColor stroke_color;
+  GColor text_color;
+  uint8_t stroke_width;
+  bool antialiased;
+  GCompOp compositing_mode;
+} DrawState;
+
+struct GContext {
+  DrawState state;
+  bool framebuffer_captured;
+};
+
+struct FontInfo {
+  int unused;
+};
+
+static GContext context;
+static struct FontInfo system_font;
+
+static const DrawState DEFAULT_DRAW_STATE = {
+  .drawing_box = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT } },
+  .clip_box = { { 0, 0 }, { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT } },
+  .fill_color = { .argb = GColorBlackARGB8 },
+  .stroke_color = { .argb = GColorBlackARGB8 },
+  .text_color = { .argb = GColorBlackARGB8 },
+  .stroke_width = 1,
+  .antialiased = PBL_IF_COLOR_ELSE(true, false),
+  .compositing_mode = GCompOpAssign,
+};
+
+GContext *harness_graphics_context(void) {
+  context.state = DEFAULT_DRAW_STATE;
+  return &context;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return &system_font;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->state.fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->state.stroke_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->state.text_color = color;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+  ctx->state.stroke_width = MAX(stroke_width, 1);
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->state.compositing_mode = mode;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+  ctx->state.antialiased = enable;
+}
+
+// rect in layer coordinates to the part of the screen it may draw on
+static GRect visible_rect(GContext *ctx, GRect rect) {
+  rect = grect_offset(rect, ctx->state.drawing_box.origin);
+  grect_clip(&rect, &ctx->state.clip_box);
+  grect_clip(&rect, &SCREEN);
+  return rect;
+}
+
+// corners are drawn square, nothing the face fills is rounded; fills blend by
+// alpha on color and replace the pixel on black & white, whatever the compositing mode
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  if (ctx->framebuffer_captured || ctx->state.fill_color.a == 0) {
+    return;
+  }
+  GRect visible = visible_rect(ctx, rect);
+  for (int y = visible.origin.y; y < visible.origin.y + visible.size.h; y++) {
+    framebuffer_fill_span(y, visible.origin.x, visible.origin.x + visible.size.w, ctx->state.fill_color.argb);
+  }
+}
+
+// tiles the bitmap if rect is larger than it, like the SDK
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  if (ctx->framebuffer_captured || !bitmap || bitmap->bounds.size.w <= 0 || bitmap->bounds.size.h <= 0) {
+    return;
+  }
+  GRect target = grect_offset(rect, ctx->state.drawing_box.origin);
+  GRect visible = visible_rect(ctx, rect);
+  GRect source = bitmap->bounds;
+  for (int y = visible.origin.y; y < visible.origin.y + visible.size.h; y++) {
+    int source_y = source.origin.y + (y - target.origin.y) % source.size.h;
+    for (int x = visible.origin.x; x < visible.origin.x + visible.size.w; x++) {
+      int source_x = source.origin.x + (x - target.origin.x) % source.size.w;
+      framebuffer_put(x, y, bitmap_pixel(bitmap, source_x, source_y), ctx->state.compositing_mode);
+    }
+  }
+}
+
+// x0 to x1 of row y in layer coordinates, clipped, as fills draw it
+static void fill_span(GContext *ctx, int y, int x0, int x1, uint8_t argb) {
+  GRect visible = visible_rect(ctx, GRect(x0, y, x1 - x0, 1));
+  if (visible.size.w > 0 && visible.size.h > 0) {
+    framebuffer_fill_span(visible.origin.y, visible.origin.x, visible.origin.x + visible.size.w, argb);
+  }
+}
+
+// Reference model of circles and lines, see harness.h; test/raster.c compares
+// the face's own rasterizer with it.
+
+// midpoint circle, each step's columns filled between the two halves
+void harness_model_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  if (ctx->framebuffer_captured || ctx->state.fill_color.a == 0) {
+    return;
+  }
+  uint8_t argb = ctx->state.fill_color.argb;
+  for (int y = p.y - radius; y <= p.y + radius; y++) {
+    fill_span(ctx, y, p.x, p.x + 1, argb);
+  }
+  int f = 1 - radius, ddf_x = 1, ddf_y = -2 * radius;
+  int x = 0, y = radius;
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddf_y += 2;
+      f += ddf_y;
+    }
+    x++;
+    ddf_x += 2;
+    f += ddf_x;
+    for (int row = p.y - y; row <= p.y + y; row++) {
+      fill_span(ctx, row, p.x - x, p.x - x + 1, argb);
+      fill_span(ctx, row, p.x + x, p.x + x + 1, argb);
+    }
+    for (int row = p.y - x; row <= p.y + x; row++) {
+      fill_span(ctx, row, p.x - y, p.x - y + 1, argb);
+      fill_span(ctx, row, p.x + y, p.x + y + 1, argb);
+    }
+  }
+}
+
+// Bresenham for 1 pixel; wider strokes are the rectangle stroke_width wide
+// around the line, the pixels whose center is inside it, with round caps
+void harness_model_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  if (ctx->framebuffer_captured || ctx->state.stroke_color.a == 0) {
+    return;
+  }
+  uint8_t argb = ctx->state.stroke_color.argb;
+  int width = ctx->state.stroke_width;
+  if (width == 1) {
+    int dx = abs(p1.x - p0.x), sx = p0.x < p1.x ? 1 : -1;
+    int dy = -abs(p1.y - p0.y), sy = p0.y < p1.y ? 1 : -1;
+    int error = dx + dy;
+    for (GPoint p = p0;;) {
+      fill_span(ctx, p.y, p.x, p.x + 1, argb);
+      if (p.x == p1.x && p.y == p1.y) {
+        break;
+      }
+      int e2 = 2 * error;
+      if (e2 >= dy) {
+        error += dy;
+        p.x += sx;
+      }
+      if (e2 <= dx) {
+        error += dx;
+        p.y += sy;
+      }
+    }
+    return;
+  }
+
+  GColor fill_color = ctx->state.fill_color;
+  ctx->state.fill_color = ctx->state.stroke_color;
+  harness_model_fill_circle(ctx, p0, width / 2);
+  harness_model_fill_circle(ctx, p1, width / 2);
+  ctx->state.fill_color = fill_color;
+
+  // pixel centers within width / 2 of the axis, between the perpendiculars
+  // through the ends; the tolerance keeps centers exactly on an edge inside
+  double dx = p1.x - p0.x, dy = p1.y - p0.y, length = sqrt(dx * dx + dy * dy);
+  if (length == 0) {
+    return;
+  }
+  const double tolerance = 1e-9;
+  for (int y = MIN(p0.y, p1.y) - width; y <= MAX(p0.y, p1.y) + width; y++) {
+    for (int x = MIN(p0.x, p1.x) - width; x <= MAX(p0.x, p1.x) + width; x++) {
+      double across = fabs(dx * (y - p0.y) - dy * (x - p0.x)) / length;
+      double along = (dx * (x - p0.x) + dy * (y - p0.y)) / length;
+      if (across <= width / 2.0 + tolerance && along >= -tolerance && along <= length + tolerance) {
+        fill_span(ctx, y, x, x + 1, argb);
+      }
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  harness_model_fill_circle(ctx, p, radius);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  harness_model_draw_line(ctx, p0, p1);
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment, GTextAttributes *text_attributes) {
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  return graphics_capture_frame_buffer_format(ctx, FRAMEBUFFER_FORMAT);
+}
+
+GBitmap *graphics_capture_frame_buffer_format(GContext *ctx, GBitmapFormat format) {
+  if (ctx->framebuffer_captured || format != FRAMEBUFFER_FORMAT) {
+    return NULL;
+  }
+  ctx->framebuffer_captured = true;
+  return &framebuffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  if (!ctx->framebuffer_captured || buffer != &framebuffer) {
+    return false;
+  }
+  ctx->framebuffer_captured = false;
+  return true;
+}
+
+// Layers and windows
+
+// same field order as the firmware; effect_layer.c looks for the parent pointer
+struct Layer {
+  GRect bounds;
+  GRect frame;
+  bool clips:1;
+  bool hidden:1;
+  bool has_data:1;
+  Layer *next_sibling;
+  Layer *parent;
+  Layer *first_child;
+  Window *window;
+  LayerUpdateProc update_proc;
+};
+
+struct Window {
+  Layer layer;
+  GColor background_color;
+};
+
+struct BitmapLayer {
+  Layer layer;
+  const GBitmap *bitmap;
+  GColor background_color;
+  GAlign alignment;
+  GCompOp compositing_mode;
+};
+
+static Window *top_window;
+static bool dirty;
+
+static void layer_init(Layer *layer, GRect frame) {
+  memset(layer, 0, sizeof(Layer));
+  layer->frame = frame;
+  layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  layer->clips = true;
+}
+
+// children are left alone, not destroyed, like the firmware does
+static void layer_deinit(Layer *layer) {
+  layer_remove_from_parent(layer);
+  for (Layer *child = layer->first_child; child; ) {
+    Layer *next = child->next_sibling;
+    child->parent = NULL;
+    child->next_sibling = NULL;
+    child = next;
+  }
+  layer->first_child = NULL;
+}
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = harness_malloc(sizeof(Layer));
+  if (layer) {
+    layer_init(layer, frame);
+  }
+  return layer;
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = harness_malloc(sizeof(Layer) + data_size);
+  if (layer) {
+    layer_init(layer, frame);
+    layer->has_data = true;
+  }
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  if (!layer) {
+    return;
+  }
+  layer_deinit(layer);
+  harness_free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+  return layer->has_data ? (void *)(layer + 1) : NULL;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  dirty = true;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  child->parent = parent;
+  Layer **last = &parent->first_child;
+  while (*last) last = &(*last)->next_sibling;
+  *last = child;
+  dirty = true;
+}
+
+void layer_remove_from_parent(Layer *child) {
+  if (!child->parent) {
+    return;
+  }
+  Layer **link = &child->parent->first_child;
+  while (*link != child) link = &(*link)->next_sibling;
+  *link = child->next_sibling;
+  child->parent = NULL;
+  child->next_sibling = NULL;
+  dirty = true;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+// bounds that just covered the old frame follow it
+void layer_set_frame(Layer *layer, GRect frame) {
+  if (layer->bounds.origin.x == 0 && layer->bounds.origin.y == 0 && gsize_equal(&layer->bounds.size, &layer->frame.size)) {
+    layer->bounds.size = frame.size;
+  }
+  layer->frame = frame;
+  dirty = true;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return layer->bounds;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+  layer->bounds = bounds;
+  dirty = true;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+  layer->clips = clips;
+  dirty = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  layer->hidden = hidden;
+  dirty = true;
+}
+
+bool layer_get_hidden(const Layer *layer) {
+  return layer->hidden;
+}
+
+Window *layer_get_window(const Layer *layer) {
+  while (layer->parent) layer = layer->parent;
+  return layer->window;
+}
+
+static void bitmap_layer_update_proc(Layer *layer, GContext *ctx) {
+  BitmapLayer *bitmap_layer = (BitmapLayer *)layer;
+  if (bitmap_layer->background_color.a) {
+    graphics_context_set_fill_color(ctx, bitmap_layer->background_color);
+    graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+  }
+  if (!bitmap_layer->bitmap) {
+    return;
+  }
+
+  GSize size = bitmap_layer->bitmap->bounds.size;
+  GRect rect = GRect(0, 0, size.w, size.h);
+  int spare_w = layer->bounds.size.w - size.w, spare_h = layer->bounds.size.h - size.h;
+  switch (bitmap_layer->alignment) {
+    case GAlignTopLeft: break;
+    case GAlignTop: rect.origin.x = spare_w / 2; break;
+    case GAlignTopRight: rect.origin.x = spare_w; break;
+    case GAlignLeft: rect.origin.y = spare_h / 2; break;
+    case GAlignRight: rect.origin = GPoint(spare_w, spare_h / 2); break;
+    case GAlignBottomLeft: rect.origin.y = spare_h; break;
+    case GAlignBottom: rect.origin = GPoint(spare_w / 2, spare_h); break;
+    case GAlignBottomRight: rect.origin = GPoint(spare_w, spare_h); break;
+    default: rect.origin = GPoint(spare_w / 2, spare_h / 2); break;
+  }
+  graphics_context_set_compositing_mode(ctx, bitmap_layer->compositing_mode);
+  graphics_draw_bitmap_in_rect(ctx, bitmap_layer->bitmap, grect_offset(rect, layer->bounds.origin));
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+  BitmapLayer *bitmap_layer = harness_malloc(sizeof(BitmapLayer));
+  if (!bitmap_layer) {
+    return NULL;
+  }
+  memset(bitmap_layer, 0, sizeof(BitmapLayer));
+  layer_init(&bitmap_layer->layer, frame);
+  bitmap_layer->layer.update_proc = bitmap_layer_update_proc;
+  bitmap_layer->background_color = GColorClear;
+  bitmap_layer->alignment = GAlignCenter;
+  bitmap_layer->compositing_mode = GCompOpAssign;
+  return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+  if (!bitmap_layer) {
+    return;
+  }
+  layer_deinit(&bitmap_layer->layer);
+  harness_free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+  return (Layer *)&bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+  bitmap_layer->bitmap = bitmap;
+  dirty = true;
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment) {
+  bitmap_layer->alignment = alignment;
+  dirty = true;
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color) {
+  bitmap_layer->background_color = color;
+  dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+  bitmap_layer->compositing_mode = mode;
+  dirty = true;
+}
+
+Window *window_create(void) {
+  Window *window = harness_malloc(sizeof(Window));
+  if (!window) {
+    return NULL;
+  }
+  layer_init(&window->layer, SCREEN);
+  window->layer.window = window;
+  window->background_color = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (!window) {
+    return;
+  }
+  if (top_window == window) {
+    top_window = NULL;
+  }
+  layer_deinit(&window->layer);
+  harness_free(window);
+}
+
+void window_stack_push(Window *window, bool animated) {
+  top_window = window;
+  dirty = true;
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *)&window->layer;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+  dirty = true;
+}
+
+// Rendering, the whole window every frame like the firmware
+
+static HarnessFrameHandler frame_handler;
+
+// offset is where the parent's bounds start on screen
+static void render_layer(Layer *layer, GPoint offset, GRect clip) {
+  if (layer->hidden) {
+    return;
+  }
+  GRect frame = grect_offset(layer->frame, offset);
+  if (layer->clips) {
+    grect_clip(&clip, &frame);
+    if (clip.size.w == 0 || clip.size.h == 0) {
+      return;
+    }
+  }
+  GRect drawing_box = grect_offset(layer->bounds, frame.origin);
+
+  if (layer->update_proc) {
+    DrawState saved = context.state;
+    context.state.drawing_box = drawing_box;
+    context.state.clip_box = clip;
+    layer->update_proc(layer, &context);
+    context.state = saved;
+    context.framebuffer_captured = false;
+  }
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    render_layer(child, drawing_box.origin, clip);
+  }
+}
+
+void harness_render_all(void) {
+  if (!top_window) {
+    return;
+  }
+  dirty = false;
+  drawing = true;
+  context.state = DEFAULT_DRAW_STATE;
+  context.framebuffer_captured = false;
+  if (top_window->background_color.a) {
+    graphics_context_set_fill_color(&context, top_window->background_color);
+    graphics_fill_rect(&context, SCREEN, 0, GCornerNone);
+  }
+  render_layer(&top_window->layer, GPointZero, SCREEN);
+  drawing = false;
+  counts.frames++;
+  if (frame_handler) {
+    frame_handler();
+  }
+}
+
+bool harness_render(void) {
+  if (!top_window || !dirty) {
+    return false;
+  }
+  harness_render_all();
+  return true;
+}
+
+void harness_set_frame_handler(HarnessFrameHandler handler) {
+  frame_handler = handler;
+}
+
+// Clocks and timers
+
+typedef struct {
+  uint32_t id;  // 0 for a free slot; handles are ids, so stale ones are harmless
+  uint64_t due_ms;
+  AppTimerCallback callback;
+  void *data;
+} Timer;
+
+static uint64_t uptime_ms;
+static int64_t wall_offset_ms;  // wall clock minus uptime
+static Timer timers[MAX_TIMERS];
+static uint32_t last_timer_id;
+
+static int64_t wall_ms(void) {
+  return (int64_t)uptime_ms + wall_offset_ms;
+}
+
+time_t time(time_t *tloc) {
+  time_t now = wall_ms() / 1000;
+  if (tloc) {
+    *tloc = now;
+  }
+  return now;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  uint16_t ms = wall_ms() % 1000;
+  if (t_utc) *t_utc = wall_ms() / 1000;
+  if (out_ms) *out_ms = ms;
+  return ms;
+}
+
+void harness_set_time(time_t time) {
+  wall_offset_ms = (int64_t)time * 1000 - (int64_t)uptime_ms;
+}
+
+time_t harness_get_time(void) {
+  return wall_ms() / 1000;
+}
+
+static Timer *find_timer(AppTimer *timer_handle) {
+  uint32_t id = (uint32_t)(uintptr_t)timer_handle;
+  for (int i = 0; id && i < MAX_TIMERS; i++) {
+    if (timers[i].id == id) {
+      return &timers[i];
+    }
+  }
+  return NULL;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    if (!timers[i].id) {
+      timers[i] = (Timer){ ++last_timer_id, uptime_ms + timeout_ms, callback, callback_data };
+      return (AppTimer *)(uintptr_t)timers[i].id;
+    }
+  }
+  APP_LOG(APP_LOG_LEVEL_ERROR, "harness: more than %d timers", MAX_TIMERS);
+  return NULL;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  Timer *timer = find_timer(timer_handle);
+  if (!timer) {
+    return false;
+  }
+  timer->due_ms = uptime_ms + new_timeout_ms;
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  Timer *timer = find_timer(timer_handle);
+  if (timer) {
+    timer->id = 0;
+  }
+}
+
+uint32_t harness_pending_timers(void) {
+  uint32_t pending = 0;
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    if (timers[i].id) pending++;
+  }
+  return pending;
+}
+
+// earliest timer due by until_ms, registration order breaking ties
+static Timer *next_due_timer(uint64_t until_ms) {
+  Timer *next = NULL;
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    Timer *timer = &timers[i];
+    if (timer->id && timer->due_ms <= until_ms &&
+        (!next || timer->due_ms < next->due_ms || (timer->due_ms == next->due_ms && timer->id < next->id))) {
+      next = timer;
+    }
+  }
+  return next;
+}
+
+void harness_advance_ms(uint32_t ms) {
+  uint64_t until_ms = uptime_ms + ms;
+  Timer *timer;
+  while ((timer = next_due_timer(until_ms))) {
+    uptime_ms = MAX(uptime_ms, timer->due_ms);
+    Timer fired = *timer;
+    timer->id = 0;
+    fired.callback(fired.data);
+    harness_render();
+  }
+  uptime_ms = until_ms;
+}
+
+// Services
+
+static TickHandler tick_handler;
+static BatteryStateHandler battery_handler;
+static BluetoothConnectionHandler connection_handler;
+static BatteryChargeState battery_state;
+static bool connected;
+static bool clock_24h;
+static uint32_t vibes;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  tick_handler = NULL;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+  battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+  battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return battery_state;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+  connection_handler = handler;
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+  connection_handler = NULL;
+}
+
+bool bluetooth_connection_service_peek(void) {
+  return connected;
+}
+
+bool clock_is_24h_style(void) {
+  return clock_24h;
+}
+
+void vibes_short_pulse(void) {
+  vibes++;
+}
+
+void vibes_long_pulse(void) {
+  vibes++;
+}
+
+void vibes_double_pulse(void) {
+  vibes++;
+}
+
+uint32_t harness_vibe_count(void) {
+  return vibes;
+}
+
+void harness_tick(TimeUnits units_changed) {
+  if (tick_handler) {
+    time_t now = harness_get_time();
+    tick_handler(localtime(&now), units_changed);
+  }
+  harness_render();
+}
+
+void harness_set_battery(BatteryChargeState charge) {
+  bool changed = memcmp(&charge, &battery_state, sizeof(charge)) != 0;
+  battery_state = charge;
+  if (changed && battery_handler) {
+    battery_handler(charge);
+  }
+  harness_render();
+}
+
+void harness_set_connected(bool is_connected) {
+  bool changed = is_connected != connected;
+  connected = is_connected;
+  if (changed && connection_handler) {
+    connection_handler(is_connected);
+  }
+  harness_render();
+}
+
+void harness_set_24h_style(bool is_24h) {
+  clock_24h = is_24h;
+}
+
+// Math, the SDK's lookup tables to full precision
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t)lround(sin((angle % TRIG_MAX_ANGLE) * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t)lround(cos((angle % TRIG_MAX_ANGLE) * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+// Logging
+
+static HarnessLogHandler log_handler;
+
+void harness_set_log_handler(HarnessLogHandler handler) {
+  log_handler = handler;
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  char message[LOG_LINE_LENGTH];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(message, sizeof(message), fmt, args);
+  va_end(args);
+
+  if (log_handler) {
+    log_handler(log_level, message);
+  } else if (log_level <= APP_LOG_LEVEL_WARNING) {
+    fprintf(stderr, "%s:%d: %s\n", src_filename, src_line_number, message);
+  }
+}
+
+// Storage
+
+typedef struct {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry persist[MAX_PERSIST_KEYS];
+
+static PersistEntry *persist_find(uint32_t key) {
+  for (int i = 0; i < MAX_PERSIST_KEYS; i++) {
+    if (persist[i].used && persist[i].key == key) {
+      return &persist[i];
+    }
+  }
+  return NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+  return persist_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  PersistEntry *entry = persist_find(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  PersistEntry *entry = persist_find(key);
+  if (entry) {
+    memcpy(&value, entry->data, MIN(entry->size, sizeof(value)));
+  }
+  return value;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  size_t size = MIN(buffer_size, entry->size);
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  PersistEntry *entry = persist_find(key);
+  for (int i = 0; !entry && i < MAX_PERSIST_KEYS; i++) {
+    if (!persist[i].used) entry = &persist[i];
+  }
+  if (!entry) {
+    return E_OUT_OF_STORAGE;
+  }
+  entry->used = true;
+  entry->key = key;
+  entry->size = MIN(size, PERSIST_DATA_MAX_LENGTH);
+  memcpy(entry->data, data, entry->size);
+  return entry->size;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+  return persist_write_data(key, &value, sizeof(value));
+}
+
+status_t persist_delete(const uint32_t key) {
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+  return S_SUCCESS;
+}
+
+// Dictionaries: a count byte, then packed tuples
+
+struct DictionaryIterator {
+  uint8_t *dictionary;
+  uint8_t *end;
+  uint8_t *cursor;
+};
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+  uint32_t size = 1 + tuple_count * sizeof(Tuple);
+  va_list sizes;
+  va_start(sizes, tuple_count);
+  for (int i = 0; i < tuple_count; i++) {
+    size += va_arg(sizes, uint32_t);
+  }
+  va_end(sizes);
+  return size;
+}
+
+static void dict_write_begin(DictionaryIterator *iter, uint8_t *buffer, uint32_t size) {
+  iter->dictionary = buffer;
+  iter->end = buffer + size;
+  iter->cursor = buffer + 1;
+  buffer[0] = 0;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  uint8_t *position = iter->dictionary + 1;
+  for (int i = 0; i < iter->dictionary[0]; i++) {
+    Tuple *tuple = (Tuple *)position;
+    if (tuple->key == key) {
+      return tuple;
+    }
+    position += sizeof(Tuple) + tuple->length;
+  }
+  return NULL;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size) {
+  if (iter->cursor + sizeof(Tuple) + size > iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  Tuple *tuple = (Tuple *)iter->cursor;
+  tuple->key = key;
+  tuple->type = TUPLE_BYTE_ARRAY;
+  tuple->length = size;
+  memcpy(tuple->value->data, data, size);
+  iter->cursor += sizeof(Tuple) + size;
+  iter->dictionary[0]++;
+  return DICT_OK;
+}
+
+// AppMessage, the buffers come out of the app heap like on the watch
+
+static AppMessageInboxReceived inbox_received;
+static AppMessageInboxDropped inbox_dropped;
+static AppMessageOutboxSent outbox_sent;
+static AppMessageOutboxFailed outbox_failed;
+static uint8_t *inbox_buffer, *outbox_buffer;
+static uint32_t inbox_size, outbox_size;
+static DictionaryIterator outbox;
+static bool outbox_busy;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  if (inbox_buffer) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  inbox_buffer = harness_malloc(size_inbound);
+  outbox_buffer = harness_malloc(size_outbound);
+  if (!inbox_buffer || !outbox_buffer) {
+    return APP_MSG_OUT_OF_MEMORY;
+  }
+  inbox_size = size_inbound;
+  outbox_size = size_outbound;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (!outbox_buffer) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  if (outbox_busy) {
+    return APP_MSG_BUSY;
+  }
+  dict_write_begin(&outbox, outbox_buffer, outbox_size);
+  outbox_busy = true;
+  *iterator = &outbox;
+  return APP_MSG_OK;
+}
+
+// the phone acks right away, on the next turn of the event loop
+static void deliver_outbox_sent(void *data) {
+  outbox_busy = false;
+  if (outbox_sent) {
+    outbox_sent(&outbox, NULL);
+  }
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (!outbox_busy) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  app_timer_register(0, deliver_outbox_sent, NULL);
+  return APP_MSG_OK;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived previous = inbox_received;
+  inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped previous = inbox_dropped;
+  inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent previous = outbox_sent;
+  outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed previous = outbox_failed;
+  outbox_failed = failed_callback;
+  return previous;
+}
+
+void harness_receive_bytes(uint32_t key, const uint8_t *data, uint16_t length) {
+  DictionaryIterator inbox;
+  if (!inbox_buffer || dict_calc_buffer_size(1, (uint32_t)length) > inbox_size) {
+    if (inbox_dropped) inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+  } else {
+    dict_write_begin(&inbox, inbox_buffer, inbox_size);
+    dict_write_data(&inbox, key, data, length);
+    if (inbox_received) inbox_received(&inbox, NULL);
+  }
+  harness_render();
+}
+
+// Resources, generated by resources.py
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  if (resource_id == 0 || resource_id >= harness_resource_count) {
+    return NULL;
+  }
+  return &harness_resources[resource_id];
+}
+
+size_t resource_size(ResHandle handle) {
+  return handle ? handle->size : 0;
+}
+
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length) {
+  if (!handle) {
+    return 0;
+  }
+  size_t size = MIN(max_length, handle->size);
+  memcpy(buffer, handle->data, size);
+  return size;
+}
+
+// App lifecycle
+
+static void (*event_loop)(void);
+
+void harness_set_event_loop(void (*loop)(void)) {
+  event_loop = loop;
+}
+
+void app_event_loop(void) {
+  // the first frame is drawn as soon as init returns
+  harness_render();
+  if (event_loop) {
+    event_loop();
+  }
+}
+
+void harness_app_exit(void) {
+  harness_free(inbox_buffer);
+  harness_free(outbox_buffer);
+  inbox_buffer = outbox_buffer = NULL;
+  memset(timers, 0, sizeof(timers));
+  tick_handler = NULL;
+  battery_handler = NULL;
+  connection_handler = NULL;
+  inbox_received = NULL;
+  inbox_dropped = NULL;
+  outbox_sent = NULL;
+  outbox_failed = NULL;
+  outbox_busy = false;
+  top_window = NULL;
+}
+
+void harness_init(time_t time) {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  memset(&heap, 0, sizeof(heap));
+  memset(&counts, 0, sizeof(counts));
+  memset(timers, 0, sizeof(timers));
+  memset(persist, 0, sizeof(persist));
+  memset(framebuffer_data, 0, sizeof(framebuffer_data));
+  uptime_ms = 0;
+  harness_set_time(time);
+  battery_state = (BatteryChargeState){ .charge_percent = 100 };
+  connected = true;
+  clock_24h = false;
+  vibes = 0;
+  dirty = false;
+}
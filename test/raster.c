@@ -0,0 +1,179 @@
+#include <pebble.h>
+#include "harness.h"
+#include "raster.h"
+#include "time_state.h"
+
+// Compares the hands' span rasterizer with the harness's reference model of the
+// shapes, see harness.h: raster_fill_circle with the model's circle for every
+// radius the face draws, and raster_line with the model's line for both hands
+// at every angle, as hand, thin hand and groove, on and off the edge of the
+// screen. The shapes are drawn white on black and the masks compared pixel by
+// pixel. The model is not the firmware: this checks the rasterizer is the
+// model, not that it draws what graphics_fill_circle and graphics_draw_line do.
+//
+// usage: raster [-v]    -v prints each mismatching shape
+
+// the face's geometry, see Watchface.c
+#define XCENTER 72
+#define YCENTER 84
+#define HOUR_BUFFER 40
+#define MINUTE_BUFFER 15
+#define HAND_WIDTH 3
+
+static const int RADII[] = { 20, 15, 6, 5 };
+
+static const TimeStateLayout LAYOUT = {
+  .screen = { HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT },
+  .hour_inset = HOUR_BUFFER,
+  .minute_inset = MINUTE_BUFFER,
+};
+
+typedef uint8_t Mask[HARNESS_SCREEN_HEIGHT][HARNESS_SCREEN_WIDTH];
+
+typedef void (*DrawShape)(GContext *ctx, const void *shape);
+
+typedef struct {
+  GPoint p0;
+  GPoint p1;
+  int width;
+} Line;
+
+typedef struct {
+  GPoint center;
+  int radius;
+} Circle;
+
+static bool verbose;
+static int shapes, failures;
+
+static void clear(GContext *ctx) {
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, GRect(0, 0, HARNESS_SCREEN_WIDTH, HARNESS_SCREEN_HEIGHT), 0, GCornerNone);
+}
+
+static int capture(Mask mask) {
+  int count = 0;
+  for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < HARNESS_SCREEN_WIDTH; x++) {
+      mask[y][x] = harness_framebuffer_pixel(x, y) != GColorBlackARGB8;
+      count += mask[y][x];
+    }
+  }
+  return count;
+}
+
+// the shape drawn both ways, false and a listing with -v if the masks differ
+static bool compare(const char *name, DrawShape reference, DrawShape raster, const void *shape) {
+  static Mask expected, actual;
+  GContext *ctx = harness_graphics_context();
+  clear(ctx);
+  reference(ctx, shape);
+  int expected_count = capture(expected);
+  clear(ctx);
+  raster(ctx, shape);
+  int actual_count = capture(actual);
+
+  int missing = 0, extra = 0;
+  for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < HARNESS_SCREEN_WIDTH; x++) {
+      missing += expected[y][x] && !actual[y][x];
+      extra += !expected[y][x] && actual[y][x];
+    }
+  }
+  shapes++;
+  if (!missing && !extra) {
+    return true;
+  }
+  failures++;
+  printf("%s: %d pixels, %d missing, %d extra (of %d)\n", name, actual_count, missing, extra, expected_count);
+  if (verbose) {
+    for (int y = 0; y < HARNESS_SCREEN_HEIGHT; y++) {
+      char row[HARNESS_SCREEN_WIDTH + 1] = { 0 };
+      bool differs = false;
+      for (int x = 0; x < HARNESS_SCREEN_WIDTH; x++) {
+        row[x] = expected[y][x] ? (actual[y][x] ? '#' : '-') : (actual[y][x] ? '+' : '.');
+        differs |= expected[y][x] != actual[y][x];
+      }
+      if (differs) printf("  %3d %s\n", y, row);
+    }
+  }
+  return false;
+}
+
+static void reference_circle(GContext *ctx, const void *shape) {
+  const Circle *circle = shape;
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  harness_model_fill_circle(ctx, circle->center, circle->radius);
+}
+
+static void raster_circle(GContext *ctx, const void *shape) {
+  const Circle *circle = shape;
+  RasterTarget target;
+  if (raster_begin(&target, ctx)) {
+    raster_fill_circle(&target, circle->center, circle->radius, GColorWhite);
+    raster_end(&target, ctx);
+  }
+}
+
+static void reference_line(GContext *ctx, const void *shape) {
+  const Line *line = shape;
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+  graphics_context_set_stroke_width(ctx, line->width);
+  harness_model_draw_line(ctx, line->p0, line->p1);
+}
+
+static void raster_line_shape(GContext *ctx, const void *shape) {
+  const Line *line = shape;
+  RasterTarget target;
+  if (raster_begin(&target, ctx)) {
+    raster_line(&target, line->p0, line->p1, line->width, GColorWhite);
+    raster_end(&target, ctx);
+  }
+}
+
+static void check_circles(void) {
+  for (int i = 0; i < (int)ARRAY_LENGTH(RADII); i++) {
+    // centered, and on a hand tip at the edge where the screen clips it
+    Circle circles[] = {
+      { GPoint(XCENTER, YCENTER), RADII[i] },
+      { time_state_hand_location(&LAYOUT, MINUTE_BUFFER, 300), RADII[i] },
+      { GPoint(2, HARNESS_SCREEN_HEIGHT - 3), RADII[i] },
+    };
+    for (int j = 0; j < (int)ARRAY_LENGTH(circles); j++) {
+      char name[64];
+      snprintf(name, sizeof(name), "circle r=%d at %d,%d", RADII[i], circles[j].center.x, circles[j].center.y);
+      compare(name, reference_circle, raster_circle, &circles[j]);
+    }
+  }
+}
+
+// every degree, sweeps pass through the ones ticks don't stop at
+static void check_hands(void) {
+  const int insets[] = { HOUR_BUFFER, MINUTE_BUFFER };
+  GPoint center = GPoint(XCENTER, YCENTER);
+  for (int i = 0; i < (int)ARRAY_LENGTH(insets); i++) {
+    for (int angle = 0; angle < 360; angle++) {
+      GPoint tip = time_state_hand_location(&LAYOUT, insets[i], angle);
+      Line lines[] = {
+        { center, tip, HAND_WIDTH },
+        { center, tip, 1 },
+        { tip, GPoint(2 * tip.x - XCENTER, 2 * tip.y - YCENTER), 1 },
+      };
+      for (int j = 0; j < (int)ARRAY_LENGTH(lines); j++) {
+        char name[64];
+        snprintf(name, sizeof(name), "line %d,%d to %d,%d width %d (inset %d, %d degrees)",
+          lines[j].p0.x, lines[j].p0.y, lines[j].p1.x, lines[j].p1.y, lines[j].width, insets[i], angle);
+        compare(name, reference_line, raster_line_shape, &lines[j]);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  verbose = argc == 2 && strcmp(argv[1], "-v") == 0;
+  harness_init(0);
+  check_circles();
+  check_hands();
+  printf("raster: %d of %d shapes differ from the reference model\n", failures, shapes);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Generates the resources of appinfo.json for the host harness, as the SDK
+would load them on one platform: resource_ids.auto.h and resources.auto.c.
+
+PNGs become the bitmap gbitmap_create_with_resource returns on the watch:
+palettized PNGs keep their palette on color platforms, anything else is 8 bit;
+black & white platforms get 1 bit bitmaps, transparent pixels black. Raw
+resources are copied, except the time glyphs, which are encoded from their
+PNGs with the wscript's own encoder.
+
+usage: resources.py basalt|aplite OUTPUT_DIR
+"""
+
+import json
+import os
+import struct
+import sys
+import types
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+COLOR_PLATFORMS = ('basalt', 'chalk')
+
+
+def load_wscript():
+    """The wscript's PNG reader and glyph encoder, without waf."""
+    waflib = types.ModuleType('waflib')
+    waflib.Logs = None
+    sys.modules.setdefault('waflib', waflib)
+    namespace = {}
+    path = os.path.join(ROOT, 'wscript')
+    with open(path) as f:
+        exec(compile(f.read(), path, 'exec'), namespace)
+    return namespace
+
+
+def argb(r, g, b, a):
+    """Nearest GColor8, the rounding encode_rle_glyph uses."""
+    return (a + 42) // 85 << 6 | (r + 42) // 85 << 4 | (g + 42) // 85 << 2 | (b + 42) // 85
+
+
+def is_light(color):
+    """Same rounding as raster_is_light and the shim's framebuffer."""
+    return ((color >> 4) & 3) + ((color >> 2) & 3) + (color & 3) >= 5
+
+
+def palette_of(wscript, path):
+    """(depth, [rgba]) of a palettized PNG, None for other color types."""
+    chunks = dict(wscript['png_chunks'](path))
+    depth, color_type = struct.unpack('>BB', chunks[b'IHDR'][8:10])
+    if color_type != 3 or depth > 4:
+        return None
+    plte, trns = bytearray(chunks[b'PLTE']), bytearray(chunks.get(b'tRNS', b''))
+    entries = [tuple(plte[i:i + 3]) + (trns[i // 3] if i // 3 < len(trns) else 255,)
+               for i in range(0, len(plte), 3)]
+    return depth, entries
+
+
+def color_bitmap(wscript, path):
+    width, height, rows = wscript['read_png'](path)
+    palettized = palette_of(wscript, path)
+    if not palettized:
+        data = bytearray(argb(*pixel) for pixels in rows for pixel in pixels)
+        return 'GBitmapFormat8Bit', width, height, width, data, b''
+
+    depth, entries = palettized
+    per_byte = 8 // depth
+    bytes_per_row = (width + per_byte - 1) // per_byte
+    data = bytearray(bytes_per_row * height)
+    for y, pixels in enumerate(rows):
+        for x, pixel in enumerate(pixels):
+            shift = 8 - depth - (x % per_byte) * depth  # most significant bits first
+            data[y * bytes_per_row + x // per_byte] |= entries.index(pixel) << shift
+    palette = bytearray(argb(*entry) for entry in entries)
+    palette += bytearray((1 << depth) - len(palette))
+    format = {1: 'GBitmapFormat1BitPalette', 2: 'GBitmapFormat2BitPalette', 4: 'GBitmapFormat4BitPalette'}[depth]
+    return format, width, height, bytes_per_row, data, palette
+
+
+def bw_bitmap(wscript, path):
+    width, height, rows = wscript['read_png'](path)
+    bytes_per_row = (width + 31) // 32 * 4  # word aligned rows, least significant bit first
+    data = bytearray(bytes_per_row * height)
+    for y, pixels in enumerate(rows):
+        for x, pixel in enumerate(pixels):
+            color = argb(*pixel)
+            if color >> 6 >= 2 and is_light(color):
+                data[y * bytes_per_row + x // 8] |= 1 << (x % 8)
+    return 'GBitmapFormat1Bit', width, height, bytes_per_row, data, b''
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('  ' + ', '.join('0x{:02x}'.format(b) for b in data[i:i + 16]) + ',')
+    return '\n'.join(lines)
+
+
+def main(platform, output_dir):
+    wscript = load_wscript()
+    with open(os.path.join(ROOT, 'appinfo.json')) as f:
+        media = json.load(f)['resources']['media']
+    glyph_sources = dict((rle, png) for png, rle in wscript['RLE_GLYPHS'])
+
+    header = ['// generated by test/resources.py from appinfo.json for {}, do not edit'.format(platform),
+              '#pragma once', '']
+    source = ['// generated by test/resources.py from appinfo.json for {}, do not edit'.format(platform),
+              '#include <pebble.h>', '#include "harness.h"', '']
+    entries = ['  { 0 },']
+
+    for resource_id, resource in enumerate(media, 1):
+        name = resource['name']
+        header.append('#define RESOURCE_ID_{} {}'.format(name, resource_id))
+        path = os.path.join(ROOT, 'resources', resource['file'])
+
+        if resource['type'] == 'png':
+            convert = color_bitmap if platform in COLOR_PLATFORMS else bw_bitmap
+            format, width, height, bytes_per_row, data, palette = convert(wscript, path)
+            source += ['static const uint8_t {}[] = {{'.format(name), c_bytes(data), '};']
+            palette_name = 'NULL'
+            if palette:
+                palette_name = '{}_PALETTE'.format(name)
+                source += ['static const uint8_t {}[] = {{'.format(palette_name), c_bytes(palette), '};']
+            entries.append('  [RESOURCE_ID_{}] = {{ {}, {}, true, {}, {{ {}, {} }}, {}, {}, {} }},'.format(
+                name, name, len(data), format, width, height, bytes_per_row, palette_name, len(palette)))
+        else:
+            if resource['file'] in glyph_sources:
+                data = bytearray(wscript['encode_rle_glyph'](os.path.join(ROOT, 'resources', glyph_sources[resource['file']])))
+            else:
+                with open(path, 'rb') as f:
+                    data = bytearray(f.read())
+            source += ['static const uint8_t {}[] = {{'.format(name), c_bytes(data), '};']
+            entries.append('  [RESOURCE_ID_{}] = {{ {}, {} }},'.format(name, name, len(data)))
+
+    source += ['', 'const HarnessResource harness_resources[] = {'] + entries + ['};',
+               'const uint32_t harness_resource_count = ARRAY_LENGTH(harness_resources);', '']
+
+    if not os.path.isdir(output_dir):
+        os.makedirs(output_dir)
+    with open(os.path.join(output_dir, 'resource_ids.auto.h'), 'w') as f:
+        f.write('\n'.join(header) + '\n')
+    with open(os.path.join(output_dir, 'resources.auto.c'), 'w') as f:
+        f.write('\n'.join(source))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2])
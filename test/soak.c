@@ -0,0 +1,165 @@
+#include <pebble.h>
+#include "harness.h"
+#include "settings.h"
+
+// Soak: a year of minute ticks, with a charge cycle a day, a connection drop
+// every few weeks and a settings change every week, through the real
+// handlers and with transitions on, so every frame a year of use would draw is
+// drawn. Allocations are counted by the shim: the blocks still live at the end
+// of each day may not outgrow what the first month needed, and nothing may be
+// left once the app exits. Errors logged by the app fail the run too.
+//
+// usage: soak
+
+int watchface_main(void);
+
+#define SOAK_DAYS 366
+#define MINUTES_PER_DAY (24 * 60)
+// days every kind of event has happened in: the start month has two digits and
+// dates of both lengths, every weekday, two connection drops and each config
+#define SOAK_WARMUP_DAYS 31
+// a connection drop every this many days, the first on day 0
+#define SOAK_DISCONNECT_EVERY_DAYS 30
+// a settings change every this many days
+#define SOAK_SETTINGS_EVERY_DAYS 7
+
+// 2015-10-01 00:00 UTC, so the run crosses a leap day and the year
+#define SOAK_START_TIME 1443657600
+
+// settings the phone sends in turn, see settings.h
+static const uint8_t CONFIGS[][CONFIG_BYTE_COUNT] = {
+  { CONFIG_PROTOCOL_VERSION, GColorRedARGB8, GColorBlueARGB8, GColorYellowARGB8, 30 },
+  { CONFIG_PROTOCOL_VERSION, GColorArmyGreenARGB8, GColorLibertyARGB8, GColorWhiteARGB8, 0 },
+  { CONFIG_PROTOCOL_VERSION, GColorArmyGreenARGB8, GColorLibertyARGB8, GColorWhiteARGB8, 20 },
+};
+
+static uint32_t errors;
+static int days;
+static uint32_t warmup_blocks, warmup_bytes;
+static bool leaked;
+
+// running least-squares fit of end-of-day live bytes over days, for the report
+static int64_t sum_x, sum_y, sum_xy, sum_xx;
+static int samples;
+
+static void on_log(uint8_t level, const char *message) {
+  if (level == APP_LOG_LEVEL_ERROR) {
+    if (++errors <= 20) printf("  error: %s\n", message);
+  }
+}
+
+static TimeUnits units_changed(const struct tm *now, const struct tm *previous) {
+  TimeUnits units = SECOND_UNIT | MINUTE_UNIT;
+  if (now->tm_hour != previous->tm_hour) units |= HOUR_UNIT;
+  if (now->tm_mday != previous->tm_mday) units |= DAY_UNIT;
+  if (now->tm_mon != previous->tm_mon) units |= MONTH_UNIT;
+  if (now->tm_year != previous->tm_year) units |= YEAR_UNIT;
+  return units;
+}
+
+// one charge cycle a day: drains 10% every two hours, charges overnight
+static BatteryChargeState battery_at(const struct tm *tick_time) {
+  bool plugged = tick_time->tm_hour < 2;
+  uint8_t percent = plugged ? 100 : 100 - 10 * MIN(tick_time->tm_hour / 2, 10);
+  return (BatteryChargeState) { .charge_percent = percent, .is_charging = plugged, .is_plugged = plugged };
+}
+
+// events of the minute that just started, then its tick and the rest of the minute
+static void run_minute(int day, const struct tm *tick_time, TimeUnits units) {
+  if (units & HOUR_UNIT) {
+    harness_set_battery(battery_at(tick_time));
+  }
+  if (units & DAY_UNIT && day % SOAK_DISCONNECT_EVERY_DAYS == 0) {
+    harness_set_connected(false);
+  }
+  if (units & HOUR_UNIT && tick_time->tm_hour == 1) {
+    harness_set_connected(true);
+  }
+  if (units & HOUR_UNIT && tick_time->tm_hour == 12 && day % SOAK_SETTINGS_EVERY_DAYS == 0) {
+    const uint8_t *config = CONFIGS[day / SOAK_SETTINGS_EVERY_DAYS % ARRAY_LENGTH(CONFIGS)];
+    harness_receive_bytes(KEY_CONFIG, config, CONFIG_BYTE_COUNT);
+  }
+  harness_tick(units);
+  harness_advance_ms(60 * 1000);
+}
+
+static void sample_heap(int day, const struct tm *date) {
+  HarnessHeap heap = harness_heap();
+  HarnessCounts counts = harness_counts();
+  if (day < SOAK_WARMUP_DAYS) {
+    warmup_blocks = MAX(warmup_blocks, heap.live_blocks);
+    warmup_bytes = MAX(warmup_bytes, heap.live_bytes);
+  } else if (heap.live_blocks > warmup_blocks || heap.live_bytes > warmup_bytes) {
+    if (!leaked) {
+      printf("  %04d-%02d-%02d: %u blocks, %u bytes live, the first month needed at most %u blocks, %u bytes\n",
+        date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, (unsigned int)heap.live_blocks,
+        (unsigned int)heap.live_bytes, (unsigned int)warmup_blocks, (unsigned int)warmup_bytes);
+    }
+    leaked = true;
+  }
+
+  if (day >= SOAK_WARMUP_DAYS) {
+    sum_x += day;
+    sum_y += heap.live_bytes;
+    sum_xy += (int64_t)day * heap.live_bytes;
+    sum_xx += (int64_t)day * day;
+    ++samples;
+  }
+
+  // one line a month, the clock is already at the next midnight
+  time_t tomorrow = harness_get_time();
+  if (gmtime(&tomorrow)->tm_mon != date->tm_mon) {
+    printf("%04d-%02d frames=%u live=%u blocks/%u bytes peak=%u bytes\n", date->tm_year + 1900, date->tm_mon + 1,
+      (unsigned int)counts.frames, (unsigned int)heap.live_blocks, (unsigned int)heap.live_bytes,
+      (unsigned int)heap.peak_bytes);
+  }
+}
+
+// starts a minute before the first day, the first tick changes every unit
+static void run_soak(void) {
+  time_t now = harness_get_time();
+  struct tm previous = *gmtime(&now);
+  harness_advance_ms(60 * 1000);
+
+  for (days = 0; days < SOAK_DAYS; days++) {
+    struct tm tick_time = previous;
+    for (int minute = 0; minute < MINUTES_PER_DAY; minute++) {
+      now = harness_get_time();
+      tick_time = *gmtime(&now);
+      run_minute(days, &tick_time, units_changed(&tick_time, &previous));
+      previous = tick_time;
+    }
+    sample_heap(days, &tick_time);
+  }
+}
+
+int main(void) {
+  harness_init(SOAK_START_TIME - 60);
+  harness_set_log_handler(on_log);
+  harness_set_event_loop(run_soak);
+  watchface_main();
+  harness_app_exit();
+
+  HarnessHeap heap = harness_heap();
+  HarnessCounts counts = harness_counts();
+  int64_t denominator = samples * sum_xx - sum_x * sum_x;
+  int slope = denominator ? (int)((samples * sum_xy - sum_x * sum_y) / denominator) : 0;
+  printf("soak: %d days, %u frames, %u mallocs, peak heap %u bytes, live heap trend %d bytes/day\n",
+    days, (unsigned int)counts.frames, (unsigned int)heap.mallocs, (unsigned int)heap.peak_bytes, slope);
+
+  int status = 0;
+  if (leaked) {
+    printf("soak: FAIL, more live at the end of a day than in the first month\n");
+    status = 1;
+  }
+  if (heap.live_blocks) {
+    printf("soak: FAIL, %u blocks (%u bytes) still allocated after deinit\n",
+      (unsigned int)heap.live_blocks, (unsigned int)heap.live_bytes);
+    status = 1;
+  }
+  if (errors) {
+    printf("soak: FAIL, %u errors logged\n", (unsigned int)errors);
+    status = 1;
+  }
+  return status;
+}
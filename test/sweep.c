@@ -0,0 +1,230 @@
+#include <pebble.h>
+#include "harness.h"
+
+// Golden frame sweep: the real watchface replays every minute of a day in each
+// of the profiler's scenarios, then the midnight of every day of a year for the
+// date, with transitions on. Every frame drawn is checksummed; frames are
+// folded into one line per scenario hour and per month, with the number of
+// frames and the allocations made while drawing and by handlers. The lines
+// are compared with a golden file, any difference fails.
+//
+// usage: sweep GOLDEN_FILE          compare, exit status 1 on any mismatch
+//        sweep --update GOLDEN_FILE rewrite it after an intended change
+
+int watchface_main(void);
+
+#define MINUTES_PER_DAY (24 * 60)
+#define SECONDS_PER_DAY (24 * 60 * 60)
+
+// 2016-12-31 00:00 UTC, a Saturday with a two digit day and month
+#define SWEEP_DAY 1483142400
+// 2016-01-01 00:00 UTC, a leap year
+#define CALENDAR_START 1451606400
+#define CALENDAR_DAYS 366
+
+// the bluetooth recheck waits 3s before the face inverts
+#define SETTLE_MS 5000
+
+#define MAX_LINES 1024
+#define LINE_LENGTH 96
+
+// same scenarios as the profiler's sweep on the watch, see src/profiler.c
+typedef struct {
+  bool    clock_24h;
+  bool    connected;
+  uint8_t charge_percent;
+  bool    plugged;
+} Scenario;
+
+static const Scenario SCENARIOS[] = {
+  { true,  true,  100, false },
+  { false, true,  100, false },
+  { true,  true,  30,  false },
+  { true,  true,  10,  false },
+  { true,  true,  50,  true  },
+  { true,  false, 100, false },
+  { false, false, 10,  false },
+};
+
+// frames and allocations since the last line
+typedef struct {
+  uint32_t hash;
+  uint32_t frames;
+  HarnessCounts start;
+} Bucket;
+
+static Bucket bucket;
+static char lines[MAX_LINES][LINE_LENGTH];
+static int line_count;
+static uint32_t most_frame_mallocs;
+static uint32_t most_event_mallocs;
+
+static void on_frame(void) {
+  static uint32_t frame_mallocs;
+  HarnessCounts counts = harness_counts();
+  most_frame_mallocs = MAX(most_frame_mallocs, counts.frame_mallocs - frame_mallocs);
+  frame_mallocs = counts.frame_mallocs;
+
+  uint32_t checksum = harness_framebuffer_checksum();
+  for (int i = 0; i < 4; i++) {
+    bucket.hash = (bucket.hash ^ ((checksum >> (8 * i)) & 0xFF)) * 16777619u;
+  }
+  bucket.frames++;
+}
+
+static void bucket_begin(void) {
+  bucket = (Bucket){ .hash = 2166136261u, .start = harness_counts() };
+}
+
+static void bucket_end(const char *label) {
+  HarnessCounts counts = harness_counts();
+  if (line_count == MAX_LINES) {
+    fprintf(stderr, "sweep: more than %d lines\n", MAX_LINES);
+    exit(2);
+  }
+  snprintf(lines[line_count++], LINE_LENGTH, "%s crc=%08x frames=%u draw_allocs=%u event_allocs=%u",
+    label, (unsigned int)bucket.hash, (unsigned int)bucket.frames,
+    (unsigned int)(counts.frame_mallocs - bucket.start.frame_mallocs),
+    (unsigned int)(counts.event_mallocs - bucket.start.event_mallocs));
+}
+
+// one tick, then the rest of the minute for transitions and timers
+static void run_minute(void) {
+  uint32_t event_mallocs = harness_counts().event_mallocs;
+  harness_tick(MINUTE_UNIT);
+  most_event_mallocs = MAX(most_event_mallocs, harness_counts().event_mallocs - event_mallocs);
+  harness_advance_ms(60 * 1000);
+}
+
+static void run_scenario(int index) {
+  const Scenario *scenario = &SCENARIOS[index];
+  char name[32];
+  snprintf(name, sizeof(name), "%s/%s/%d%%%s", scenario->clock_24h ? "24h" : "12h",
+    scenario->connected ? "bt" : "nobt", scenario->charge_percent, scenario->plugged ? "+" : "");
+
+  // state changes land just before midnight, so hour 00 shows them taking effect
+  bucket_begin();
+  harness_set_time(SWEEP_DAY - SETTLE_MS / 1000);
+  harness_set_24h_style(scenario->clock_24h);
+  harness_set_battery((BatteryChargeState){
+    .charge_percent = scenario->charge_percent, .is_charging = scenario->plugged, .is_plugged = scenario->plugged });
+  harness_set_connected(scenario->connected);
+  harness_advance_ms(SETTLE_MS);
+
+  for (int minute = 0; minute < MINUTES_PER_DAY; minute++) {
+    run_minute();
+    if (minute % 60 == 59) {
+      char label[48];
+      snprintf(label, sizeof(label), "%s %02d", name, minute / 60);
+      bucket_end(label);
+      bucket_begin();
+    }
+  }
+}
+
+// midnight of every day, the only minute the date changes
+static void run_calendar(void) {
+  harness_set_24h_style(true);
+  harness_set_battery((BatteryChargeState){ .charge_percent = 100 });
+  harness_set_connected(true);
+  harness_advance_ms(SETTLE_MS);
+
+  bucket_begin();
+  for (int day = 0; day < CALENDAR_DAYS; day++) {
+    time_t midnight = CALENDAR_START + day * SECONDS_PER_DAY;
+    harness_set_time(midnight);
+    run_minute();
+
+    time_t next = midnight + SECONDS_PER_DAY;
+    struct tm date = *gmtime(&midnight), next_date = *gmtime(&next);
+    if (next_date.tm_mon != date.tm_mon || day == CALENDAR_DAYS - 1) {
+      char label[48];
+      snprintf(label, sizeof(label), "calendar %04d-%02d", date.tm_year + 1900, date.tm_mon + 1);
+      bucket_end(label);
+      bucket_begin();
+    }
+  }
+}
+
+// the init bucket started before watchface_main, with the first frame in it
+static void run_sweep(void) {
+  harness_advance_ms(SETTLE_MS);
+  bucket_end("init");
+
+  for (int i = 0; i < (int)ARRAY_LENGTH(SCENARIOS); i++) {
+    run_scenario(i);
+  }
+  run_calendar();
+}
+
+static int write_golden(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    perror(path);
+    return 2;
+  }
+  for (int i = 0; i < line_count; i++) {
+    fprintf(file, "%s\n", lines[i]);
+  }
+  fclose(file);
+  printf("%s: %d lines written\n", path, line_count);
+  return 0;
+}
+
+static int compare_golden(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return 2;
+  }
+  int mismatches = 0, expected_count = 0;
+  char expected[LINE_LENGTH + 2];
+  while (fgets(expected, sizeof(expected), file)) {
+    expected[strcspn(expected, "\n")] = '\0';
+    const char *actual = expected_count < line_count ? lines[expected_count] : "(missing)";
+    if (strcmp(expected, actual) != 0) {
+      if (++mismatches <= 20) {
+        printf("  expected %s\n  actual   %s\n", expected, actual);
+      }
+    }
+    expected_count++;
+  }
+  fclose(file);
+  for (int i = expected_count; i < line_count; i++) {
+    if (++mismatches <= 20) printf("  unexpected %s\n", lines[i]);
+  }
+  if (mismatches) {
+    printf("%s: %d of %d lines differ\n", path, mismatches, MAX(expected_count, line_count));
+  }
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  bool update = argc == 3 && strcmp(argv[1], "--update") == 0;
+  if (argc != 2 && !update) {
+    fprintf(stderr, "usage: %s [--update] GOLDEN_FILE\n", argv[0]);
+    return 2;
+  }
+  const char *golden = argv[argc - 1];
+
+  harness_init(SWEEP_DAY);
+  harness_set_frame_handler(on_frame);
+  harness_set_event_loop(run_sweep);
+  bucket_begin();
+  watchface_main();
+  harness_app_exit();
+
+  HarnessCounts counts = harness_counts();
+  HarnessHeap heap = harness_heap();
+  printf("%s: %u frames, %u allocations while drawing (at most %u in a frame), at most %u per tick, peak heap %u bytes\n",
+    golden, (unsigned int)counts.frames, (unsigned int)counts.frame_mallocs, (unsigned int)most_frame_mallocs,
+    (unsigned int)most_event_mallocs, (unsigned int)heap.peak_bytes);
+
+  int status = update ? write_golden(golden) : compare_golden(golden);
+  if (heap.live_blocks) {
+    printf("%s: %u blocks (%u bytes) still allocated after deinit\n",
+      golden, (unsigned int)heap.live_blocks, (unsigned int)heap.live_bytes);
+    status = MAX(status, 1);
+  }
+  return status;
+}